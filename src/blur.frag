@@ -4,6 +4,7 @@ uniform sampler2D texture;
 uniform float blur_spread_px; // How many pixels apart to space the samples (e.g., 1.0, 2.0)
 uniform vec2 texture_size;   // The dimensions of the texture being blurred (e.g., 800.0, 600.0)
 uniform vec2 blur_direction; // (1.0, 0.0) for horizontal, (0.0, 1.0) for vertical
+uniform int blur_taps;       // Samples on each side of the center (1-4); fewer is cheaper and tighter
 
 void main() {
     // Calculate the offset for one pixel in the direction of the blur
@@ -20,14 +21,21 @@ void main() {
 
     // Accumulate color, starting with the center pixel
     vec4 sum = texture2D(texture, gl_TexCoord[0].xy) * weight[0];
+    float weight_sum = weight[0];
 
     // Sample neighboring pixels along the blur_direction
     // The blur_spread_px scales how far apart these samples are.
     for (int i = 1; i < 5; i++) {
+        if (i > blur_taps) {
+            break;
+        }
         vec2 current_offset = base_offset * float(i) * blur_spread_px;
         sum += texture2D(texture, gl_TexCoord[0].xy + current_offset) * weight[i];
         sum += texture2D(texture, gl_TexCoord[0].xy - current_offset) * weight[i];
+        weight_sum += 2.0 * weight[i];
     }
+    // Renormalize when fewer taps are used
+    sum /= weight_sum;
 
     // Modulate with vertex color (sf::Sprite defaults to white)
     gl_FragColor = gl_Color * sum;
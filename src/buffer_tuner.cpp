@@ -0,0 +1,203 @@
+#include "include/buffer_tuner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// A window spans at least this long and this many callbacks before it is judged
+constexpr std::chrono::seconds kWindow{2};
+constexpr std::uint64_t kMinCallbacks = 100;
+constexpr double kPeakQuantile = 0.999;
+constexpr unsigned int kShrinkVotes = 2;
+constexpr std::chrono::seconds kFloorHold{60};
+// Peaks measured at other sizes are trusted for this long
+constexpr std::chrono::seconds kSampleLifetime{60};
+
+// Index of a power-of-two size in the per-size table, or kSizes for other sizes
+std::size_t sizeIndex(unsigned int frames, unsigned int minFrames, std::size_t sizes) {
+    std::size_t index = 0;
+    for (unsigned int size = minFrames; index < sizes; size *= 2, ++index) {
+        if (size == frames) {
+            return index;
+        }
+    }
+    return sizes;
+}
+
+} // namespace
+
+BufferTuner::BufferTuner(double margin) {
+    setMargin(margin);
+}
+
+void BufferTuner::setMargin(double margin) {
+    m_margin = std::clamp(margin, 0.0, 0.95);
+}
+
+void BufferTuner::start(unsigned int bufferFrames, unsigned int sampleRate, bool sizeFixed,
+                        std::chrono::steady_clock::time_point now) {
+    m_bufferFrames = std::max(bufferFrames, 1u);
+    m_sampleRate = std::max(sampleRate, 1u);
+    m_sizeFixed = sizeFixed;
+    m_shrinkVotes = 0;
+    resetWindow(now);
+}
+
+void BufferTuner::rejectSize(unsigned int frames, std::chrono::steady_clock::time_point now) {
+    if (frames < m_bufferFrames) {
+        // Keep to the sizes above the refused one
+        m_floorFrames = std::min(2 * frames, m_bufferFrames);
+        m_floorUntil = now + kFloorHold;
+    } else {
+        // Growth was refused: the floor raised for it no longer applies, and nothing that large is asked for
+        m_floorFrames = std::min(m_floorFrames, m_bufferFrames);
+        m_ceilingFrames = std::max(frames / 2, m_bufferFrames);
+        m_ceilingUntil = now + kFloorHold;
+    }
+    m_shrinkVotes = 0;
+}
+
+std::size_t BufferTuner::bucketOf(std::chrono::nanoseconds processing) {
+    const double us = static_cast<double>(processing.count()) / 1000.0;
+    if (us <= 1.0) {
+        return 0;
+    }
+    const auto bucket = static_cast<std::size_t>(std::log2(us) * kBucketsPerOctave);
+    return std::min(bucket, kBuckets - 1);
+}
+
+double BufferTuner::bucketLimitMs(std::size_t bucket) {
+    return std::exp2(static_cast<double>(bucket + 1) / kBucketsPerOctave) / 1000.0;
+}
+
+void BufferTuner::recordCallback(std::chrono::nanoseconds processing, bool overflow) {
+    m_histogram[bucketOf(processing)].fetch_add(1, std::memory_order_relaxed);
+    if (overflow) {
+        m_overflows.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void BufferTuner::resetWindow(std::chrono::steady_clock::time_point now) {
+    for (auto& count : m_histogram) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_overflows.store(0, std::memory_order_relaxed);
+    m_windowStart = now;
+}
+
+void BufferTuner::noteLoadChange(std::chrono::steady_clock::time_point now) {
+    m_shrinkVotes = 0;
+    m_sizeSamples = {};
+    resetWindow(now);
+}
+
+double BufferTuner::predictPeakMs(unsigned int frames, double peakMs, std::chrono::steady_clock::time_point now) const {
+    // The other recently measured size closest to the current one
+    const std::size_t current = sizeIndex(m_bufferFrames, kMinFrames, kSizes);
+    std::size_t other = kSizes;
+    for (std::size_t i = 0; i < kSizes && current < kSizes; ++i) {
+        const bool fresh = m_sizeSamples[i].peakMs > 0.0 && now - m_sizeSamples[i].at < kSampleLifetime;
+        if (i != current && fresh && (other == kSizes || (i > current ? i - current : current - i) <
+                                                          (other > current ? other - current : current - other))) {
+            other = i;
+        }
+    }
+    if (other == kSizes) {
+        return peakMs;
+    }
+    // Cost never falls as the buffer grows, and grows at most in proportion to it
+    const double otherFrames = static_cast<double>(kMinFrames << other);
+    const double slope = std::clamp((peakMs - m_sizeSamples[other].peakMs) / (m_bufferFrames - otherFrames), 0.0,
+                                    peakMs / m_bufferFrames);
+    return peakMs + slope * (static_cast<double>(frames) - m_bufferFrames);
+}
+
+bool BufferTuner::evaluate(std::chrono::steady_clock::time_point now) {
+    if (now - m_windowStart < kWindow) {
+        return false;
+    }
+    std::uint64_t callbacks = 0;
+    for (const auto& count : m_histogram) {
+        callbacks += count.load(std::memory_order_relaxed);
+    }
+    if (callbacks < kMinCallbacks) {
+        return false;
+    }
+
+    // Take the window; callbacks recorded meanwhile count towards the next one
+    std::array<std::uint32_t, kBuckets> histogram;
+    callbacks = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        histogram[i] = m_histogram[i].exchange(0, std::memory_order_relaxed);
+        callbacks += histogram[i];
+    }
+    const std::uint64_t overflows = m_overflows.exchange(0, std::memory_order_relaxed);
+    m_windowStart = now;
+    if (callbacks == 0) {
+        return false;
+    }
+
+    // Quantiles are rounded up to their bucket's limit, which errs on the safe side
+    auto quantileMs = [&](double q) {
+        const auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(callbacks)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            seen += histogram[i];
+            if (seen >= std::max<std::uint64_t>(rank, 1)) {
+                return bucketLimitMs(i);
+            }
+        }
+        return bucketLimitMs(kBuckets - 1);
+    };
+
+    Report report;
+    report.bufferFrames = m_bufferFrames;
+    report.periodMs = 1000.0 * m_bufferFrames / m_sampleRate;
+    report.medianMs = quantileMs(0.5);
+    report.peakMs = quantileMs(kPeakQuantile);
+    report.margin = 1.0 - report.peakMs / report.periodMs;
+    report.callbacks = callbacks;
+    report.overflows = overflows;
+
+    if (const std::size_t index = sizeIndex(m_bufferFrames, kMinFrames, kSizes); index < kSizes) {
+        m_sizeSamples[index] = {report.peakMs, now};
+    }
+
+    // Smallest size whose period leaves the margin free at the predicted peak time
+    unsigned int recommended = kMaxFrames;
+    for (unsigned int frames = kMinFrames; frames <= kMaxFrames; frames *= 2) {
+        const double periodMs = 1000.0 * frames / m_sampleRate;
+        if (predictPeakMs(frames, report.peakMs, now) <= (1.0 - m_margin) * periodMs) {
+            recommended = frames;
+            break;
+        }
+    }
+    // Grow at most one step per window, so a lone spike cannot send the size to the top
+    recommended = std::min(recommended, std::max(2 * m_bufferFrames, kMinFrames));
+    if (overflows > 0) {
+        recommended = std::max(recommended, std::min(2 * m_bufferFrames, kMaxFrames));
+    }
+    if (now < m_floorUntil) {
+        recommended = std::max(recommended, m_floorFrames);
+    }
+    if (now < m_ceilingUntil) {
+        recommended = std::min(recommended, m_ceilingFrames);
+    }
+    report.recommendedFrames = recommended;
+
+    if (!m_sizeFixed) {
+        if (recommended > m_bufferFrames) {
+            report.reopen = true;
+            m_floorFrames = recommended;
+            m_floorUntil = now + kFloorHold;
+        } else if (recommended < m_bufferFrames) {
+            report.reopen = ++m_shrinkVotes >= kShrinkVotes;
+        }
+    }
+    if (recommended >= m_bufferFrames) {
+        m_shrinkVotes = 0;
+    }
+    m_report = report;
+    return true;
+}
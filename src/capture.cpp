@@ -0,0 +1,308 @@
+#include "include/capture.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace capture {
+
+namespace {
+
+constexpr std::size_t kRecordAlign = 8;
+
+std::size_t paddedSize(std::size_t n) {
+    return (n + kRecordAlign - 1) & ~(kRecordAlign - 1);
+}
+
+std::size_t nextPowerOfTwo(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+// --- ByteRing ---
+
+ByteRing::ByteRing(std::size_t capacity)
+    : m_data(nextPowerOfTwo(std::max<std::size_t>(capacity, 4096))), m_mask(m_data.size() - 1) {
+}
+
+void ByteRing::copyIn(std::size_t pos, const void* src, std::size_t n) {
+    if (n == 0) {
+        return;
+    }
+    const std::size_t offset = pos & m_mask;
+    const std::size_t first = std::min(n, m_data.size() - offset);
+    std::memcpy(m_data.data() + offset, src, first);
+    std::memcpy(m_data.data(), static_cast<const std::uint8_t*>(src) + first, n - first);
+}
+
+void ByteRing::copyOut(std::size_t pos, void* dst, std::size_t n) const {
+    const std::size_t offset = pos & m_mask;
+    const std::size_t first = std::min(n, m_data.size() - offset);
+    std::memcpy(dst, m_data.data() + offset, first);
+    std::memcpy(static_cast<std::uint8_t*>(dst) + first, m_data.data(), n - first);
+}
+
+bool ByteRing::push(const CaptureRecordHeader& header, const void* prefix, std::size_t prefixBytes,
+                    const void* body, std::size_t bodyBytes) {
+    const std::size_t total = sizeof(CaptureRecordHeader) + paddedSize(header.size);
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    const std::size_t tail = m_tail.load(std::memory_order_acquire);
+    if (total > m_data.size() - (head - tail)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    copyIn(head, &header, sizeof(header));
+    copyIn(head + sizeof(header), prefix, prefixBytes);
+    copyIn(head + sizeof(header) + prefixBytes, body, bodyBytes);
+    m_head.store(head + total, std::memory_order_release);
+    return true;
+}
+
+bool ByteRing::peek(CaptureRecordHeader& header) const {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (m_head.load(std::memory_order_acquire) == tail) {
+        return false;
+    }
+    copyOut(tail, &header, sizeof(header));
+    return true;
+}
+
+void ByteRing::pop(const CaptureRecordHeader& header, void* payload) {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    copyOut(tail + sizeof(header), payload, header.size);
+    m_tail.store(tail + sizeof(header) + paddedSize(header.size), std::memory_order_release);
+}
+
+// --- CaptureRecorder ---
+
+CaptureRecorder::~CaptureRecorder() {
+    stop();
+}
+
+bool CaptureRecorder::start(const std::string& path, std::size_t audioRingBytes, std::size_t oscRingBytes) {
+    stop();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Error: Could not open capture file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Large stdio buffer so the writer thread issues few, big writes
+    m_fileBuffer.resize(1 << 20);
+    std::setvbuf(m_file, m_fileBuffer.data(), _IOFBF, m_fileBuffer.size());
+
+    writeHeader();
+
+    m_path = path;
+    m_audioRing = std::make_unique<ByteRing>(audioRingBytes);
+    m_oscRing = std::make_unique<ByteRing>(oscRingBytes);
+    m_scratch.resize(std::max(audioRingBytes, oscRingBytes) + kRecordAlign);
+    m_audioRecords = 0;
+    m_oscRecords = 0;
+    m_stopRequested = false;
+    m_startTime = std::chrono::steady_clock::now();
+    m_writer = std::thread(&CaptureRecorder::writerLoop, this);
+    m_recording.store(true, std::memory_order_release);
+
+    std::cout << "Capture: recording audio and OSC to " << path << std::endl;
+    return true;
+}
+
+void CaptureRecorder::stop() {
+    if (!m_recording.exchange(false)) {
+        return;
+    }
+    m_stopRequested = true;
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    // The rate is only certain once the input has locked on, so the header is rewritten with it now
+    std::fseek(m_file, 0, SEEK_SET);
+    writeHeader();
+    std::fclose(m_file);
+    m_file = nullptr;
+
+    std::cout << "Capture: wrote " << m_audioRecords << " audio blocks and " << m_oscRecords
+              << " OSC packets to " << m_path;
+    const std::uint64_t dropped = m_audioRing->droppedRecords() + m_oscRing->droppedRecords();
+    if (dropped > 0) {
+        std::cout << " (" << dropped << " records dropped: ring full)";
+    }
+    std::cout << std::endl;
+}
+
+void CaptureRecorder::writeHeader() {
+    CaptureFileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+    std::fwrite(&header, sizeof(header), 1, m_file);
+}
+
+std::uint64_t CaptureRecorder::elapsedNs() const {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_startTime).count());
+}
+
+void CaptureRecorder::recordAudio(const void* samples, SampleFormat format, unsigned int nFrames, unsigned int nChannels, double streamTime) {
+    if (!isRecording()) {
+        return;
+    }
+    const AudioBlockHeader block{nFrames, static_cast<std::uint16_t>(nChannels), format, streamTime};
+    const std::size_t sampleBytes = static_cast<std::size_t>(nFrames) * nChannels * bytesPerSample(format);
+    const CaptureRecordHeader header{RecordType::Audio, static_cast<std::uint32_t>(sizeof(block) + sampleBytes), elapsedNs()};
+    m_audioRing->push(header, &block, sizeof(block), samples, sampleBytes);
+}
+
+void CaptureRecorder::recordOsc(const char* data, std::size_t size) {
+    if (!isRecording()) {
+        return;
+    }
+    const CaptureRecordHeader header{RecordType::Osc, static_cast<std::uint32_t>(size), elapsedNs()};
+    m_oscRing->push(header, data, size, nullptr, 0);
+}
+
+bool CaptureRecorder::writeNext() {
+    CaptureRecordHeader audioHeader{};
+    CaptureRecordHeader oscHeader{};
+    const bool haveAudio = m_audioRing->peek(audioHeader);
+    const bool haveOsc = m_oscRing->peek(oscHeader);
+    if (!haveAudio && !haveOsc) {
+        return false;
+    }
+
+    // Merge the two streams so the file stays in timestamp order
+    const bool takeAudio = haveAudio && (!haveOsc || audioHeader.timestampNs <= oscHeader.timestampNs);
+    const CaptureRecordHeader& header = takeAudio ? audioHeader : oscHeader;
+    ByteRing& ring = takeAudio ? *m_audioRing : *m_oscRing;
+
+    const std::size_t padded = paddedSize(header.size);
+    ring.pop(header, m_scratch.data());
+    std::fill(m_scratch.begin() + header.size, m_scratch.begin() + padded, 0);
+    std::fwrite(&header, sizeof(header), 1, m_file);
+    std::fwrite(m_scratch.data(), 1, padded, m_file);
+    ++(takeAudio ? m_audioRecords : m_oscRecords);
+    return true;
+}
+
+void CaptureRecorder::writerLoop() {
+    while (true) {
+        const bool stopping = m_stopRequested.load();
+        bool wrote = false;
+        while (writeNext()) {
+            wrote = true;
+        }
+        if (stopping) {
+            break;
+        }
+        if (!wrote) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    std::fflush(m_file);
+}
+
+// --- CaptureReplayer ---
+
+CaptureReplayer::~CaptureReplayer() {
+    if (m_data) {
+        munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+}
+
+bool CaptureReplayer::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open capture file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(CaptureFileHeader)) {
+        std::cerr << "Error: " << path << " is too short to be a capture file." << std::endl;
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: Could not map capture file " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    const auto* header = static_cast<const CaptureFileHeader*>(mapped);
+    if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version < kMinVersion ||
+        header->version > kVersion) {
+        std::cerr << "Error: " << path << " is not an OSCAR capture file." << std::endl;
+        munmap(mapped, size);
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const std::uint8_t*>(mapped);
+    m_size = size;
+    m_path = path;
+    m_sampleRate = header->version >= 2 ? header->sampleRate : 0;
+    return true;
+}
+
+bool CaptureReplayer::run(ReplaySpeed speed, const AudioSink& audio, const OscSink& osc, const std::atomic<bool>& stop) {
+    const auto start = std::chrono::steady_clock::now();
+    std::uint64_t audioRecords = 0;
+    std::uint64_t oscRecords = 0;
+    std::uint64_t lastTimestampNs = 0;
+
+    std::size_t pos = sizeof(CaptureFileHeader);
+    while (pos + sizeof(CaptureRecordHeader) <= m_size) {
+        if (stop) {
+            return false;
+        }
+        CaptureRecordHeader header;
+        std::memcpy(&header, m_data + pos, sizeof(header));
+        const std::uint8_t* payload = m_data + pos + sizeof(header);
+        if (payload + header.size > m_data + m_size) {
+            std::cerr << "Replay: truncated record at offset " << pos << ", stopping." << std::endl;
+            break;
+        }
+
+        if (speed == ReplaySpeed::Realtime) {
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(header.timestampNs));
+        }
+
+        if (header.type == RecordType::Audio && header.size >= sizeof(AudioBlockHeader)) {
+            AudioBlockHeader block;
+            std::memcpy(&block, payload, sizeof(block));
+            const std::size_t sampleBytes = static_cast<std::size_t>(block.nFrames) * block.nChannels * bytesPerSample(block.format);
+            if (sampleBytes > 0 && sizeof(block) + sampleBytes <= header.size) {
+                audio(payload + sizeof(block), block.format, block.nFrames, block.nChannels, block.streamTime);
+                ++audioRecords;
+            }
+        } else if (header.type == RecordType::Osc) {
+            osc(reinterpret_cast<const char*>(payload), header.size);
+            ++oscRecords;
+        }
+
+        lastTimestampNs = header.timestampNs;
+        pos += sizeof(header) + paddedSize(header.size);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double recorded = static_cast<double>(lastTimestampNs) / 1e9;
+    std::cout << "Replay: fed " << audioRecords << " audio blocks and " << oscRecords << " OSC packets from "
+              << m_path << " in " << elapsed.count() << " s (" << recorded << " s recorded, "
+              << (elapsed.count() > 0.0 ? recorded / elapsed.count() : 0.0) << "x realtime)" << std::endl;
+    return true;
+}
+
+} // namespace capture
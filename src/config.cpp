@@ -0,0 +1,298 @@
+#include "include/config.hpp"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <cstring>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --frame-pacing <vsync|limit|unlimited>  Frame pacing mode (default: limit)\n"
+              << "  --fps <n>                               Frame rate for 'limit' pacing (default: 60)\n"
+              << "  --target-frame-ms <ms>                  Frame time the quality governor defends (default: 1000/fps)\n"
+              << "  --lock-quality                          Never degrade quality under load (for recorded renders)\n"
+              << "  --measure-latency                       Report audio-to-photon latency once per second\n"
+              << "  --export-shm <name>                     Publish frames to a POSIX shared-memory ring, e.g. /oscar\n"
+              << "  --export-slots <n>                      Frames kept in the shared-memory ring (default: 3)\n"
+              << "  --record <file>                         Capture raw audio blocks and OSC packets to a file\n"
+              << "  --replay <file>                         Replay a capture instead of live audio and OSC\n"
+              << "  --replay-speed <realtime|fast>          Replay pacing (default: realtime)\n"
+              << "  --input <device|udp>                    Audio input: the audio device or a UDP stream (default: device)\n"
+              << "  --udp-port <n>                          Port for --input udp (default: 7001)\n"
+              << "  --sample-format <auto|int16|int24|int32|float32>\n"
+              << "                                          Device stream format (default: auto, the native format)\n"
+              << "  --buffer-frames <n>                     Device buffer size in frames (default: 256)\n"
+              << "  --tune-latency                          Measure the audio callback and reopen the device with the\n"
+              << "                                          smallest buffer that keeps the latency margin free\n"
+              << "  --latency-margin <x>                    Share of the buffer period the callback must leave free\n"
+              << "                                          (0-0.95, default: 0.5)\n"
+              << "  --memory-budget <mb>                    Memory for all scope history and geometry, split evenly\n"
+              << "                                          between the scopes (16-1048576, default: 256)\n"
+              << "  --stream <device>=<scope>[,<scope>...]  Open a separate input stream for these scopes; repeat\n"
+              << "                                          for more streams, the first one sets the clock\n"
+              << "  --output <kind>:<w>x<h>[@<fps>][:<scope>,...]\n"
+              << "                                          Add a render output; kind is window, offscreen or\n"
+              << "                                          shm=<name>. fps 0 is unlimited. Repeat for more outputs\n"
+              << "  --rt-selftest                           Drive the audio callback headlessly and fail on\n"
+              << "                                          realtime violations (needs an RT_CHECK=1 build)\n"
+              << "  --help                                  Show this message" << std::endl;
+}
+
+bool parseUnsigned(const char* text, unsigned int& out) {
+    try {
+        std::size_t used = 0;
+        unsigned long val = std::stoul(text, &used);
+        if (used != std::strlen(text) || val == 0) {
+            return false;
+        }
+        out = static_cast<unsigned int>(val);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Parses <kind>:<w>x<h>[@<fps>][:<scope>,...]; a missing fps means defaultFrameRate
+bool parseOutputSpec(const std::string& text, unsigned int defaultFrameRate, OutputSpec& output) {
+    const auto first = text.find(':');
+    if (first == std::string::npos) {
+        return false;
+    }
+    const std::string kind = text.substr(0, first);
+    if (kind == "window") {
+        output.kind = OutputKind::Window;
+    } else if (kind == "offscreen") {
+        output.kind = OutputKind::Offscreen;
+    } else if (kind.rfind("shm=", 0) == 0 && kind.size() > 4) {
+        output.kind = OutputKind::Offscreen;
+        output.shmName = kind.substr(4);
+    } else {
+        return false;
+    }
+
+    const auto second = text.find(':', first + 1);
+    std::string mode = text.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+    output.frameRate = defaultFrameRate;
+    if (const auto at = mode.find('@'); at != std::string::npos) {
+        const std::string fps = mode.substr(at + 1);
+        if (fps == "0") {
+            output.frameRate = 0;
+        } else if (!parseUnsigned(fps.c_str(), output.frameRate)) {
+            return false;
+        }
+        mode.resize(at);
+    }
+    const auto x = mode.find('x');
+    if (x == std::string::npos || !parseUnsigned(mode.substr(0, x).c_str(), output.width) ||
+        !parseUnsigned(mode.substr(x + 1).c_str(), output.height)) {
+        return false;
+    }
+
+    if (second != std::string::npos) {
+        std::size_t pos = second + 1;
+        while (pos <= text.size()) {
+            const auto comma = std::min(text.find(',', pos), text.size());
+            const std::string index = text.substr(pos, comma - pos);
+            unsigned int scope = 0;
+            if (index.empty() || (index != "0" && !parseUnsigned(index.c_str(), scope))) {
+                return false;
+            }
+            output.scopes.push_back(scope);
+            pos = comma + 1;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<RenderConfig> parseCommandLine(int argc, char* argv[]) {
+    RenderConfig config;
+    // Parsed at the end, so their default frame rate honors --fps wherever it appears
+    std::vector<std::string> outputSpecs;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return std::nullopt;
+        } else if (arg == "--frame-pacing" && hasValue) {
+            const std::string mode = argv[++i];
+            if (mode == "vsync") {
+                config.framePacing = FramePacing::VSync;
+            } else if (mode == "limit") {
+                config.framePacing = FramePacing::Limit;
+            } else if (mode == "unlimited") {
+                config.framePacing = FramePacing::Unlimited;
+            } else {
+                std::cerr << "Error: Unknown frame pacing mode: " << mode << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--fps" && hasValue) {
+            if (!parseUnsigned(argv[++i], config.frameRateLimit)) {
+                std::cerr << "Error: Invalid frame rate: " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--target-frame-ms" && hasValue) {
+            double ms = 0.0;
+            try {
+                ms = std::stod(argv[++i]);
+            } catch (const std::exception&) {
+            }
+            if (!(ms > 0.0)) {
+                std::cerr << "Error: Invalid target frame time: " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            config.targetFrameMs = ms;
+        } else if (arg == "--lock-quality") {
+            config.lockQuality = true;
+        } else if (arg == "--measure-latency") {
+            config.measureLatency = true;
+        } else if (arg == "--export-shm" && hasValue) {
+            config.exportShmName = argv[++i];
+            if (config.exportShmName.empty() || config.exportShmName[0] != '/') {
+                config.exportShmName.insert(0, "/");
+            }
+        } else if (arg == "--export-slots" && hasValue) {
+            if (!parseUnsigned(argv[++i], config.exportSlotCount) || config.exportSlotCount < 2) {
+                std::cerr << "Error: Invalid export slot count (minimum 2): " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--record" && hasValue) {
+            config.recordPath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            config.replayPath = argv[++i];
+        } else if (arg == "--replay-speed" && hasValue) {
+            const std::string speed = argv[++i];
+            if (speed == "realtime") {
+                config.replaySpeed = capture::ReplaySpeed::Realtime;
+            } else if (speed == "fast") {
+                config.replaySpeed = capture::ReplaySpeed::AsFastAsPossible;
+            } else {
+                std::cerr << "Error: Unknown replay speed: " << speed << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--input" && hasValue) {
+            const std::string input = argv[++i];
+            if (input == "device") {
+                config.inputSource = InputSource::Device;
+            } else if (input == "udp") {
+                config.inputSource = InputSource::Udp;
+            } else {
+                std::cerr << "Error: Unknown input source: " << input << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--udp-port" && hasValue) {
+            if (!parseUnsigned(argv[++i], config.udpPort) || config.udpPort > 65535) {
+                std::cerr << "Error: Invalid UDP port: " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--sample-format" && hasValue) {
+            const std::string format = argv[++i];
+            if (format == "auto") {
+                config.sampleFormat.reset();
+            } else if (auto parsed = parseSampleFormat(format)) {
+                config.sampleFormat = parsed;
+            } else {
+                std::cerr << "Error: Unknown sample format: " << format << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--buffer-frames" && hasValue) {
+            if (!parseUnsigned(argv[++i], config.bufferFrames) || config.bufferFrames < 16 || config.bufferFrames > 8192) {
+                std::cerr << "Error: Invalid buffer size (16-8192 frames): " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+        } else if (arg == "--tune-latency") {
+            config.tuneLatency = true;
+        } else if (arg == "--latency-margin" && hasValue) {
+            double margin = -1.0;
+            try {
+                margin = std::stod(argv[++i]);
+            } catch (const std::exception&) {
+            }
+            if (!(margin >= 0.0 && margin <= 0.95)) {
+                std::cerr << "Error: Invalid latency margin (0-0.95): " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            config.latencyMargin = margin;
+        } else if (arg == "--memory-budget" && hasValue) {
+            unsigned int megabytes = 0;
+            if (!parseUnsigned(argv[++i], megabytes) || megabytes < 16 || megabytes > (1u << 20)) {
+                std::cerr << "Error: Invalid memory budget (16-1048576 MB): " << argv[i] << std::endl;
+                return std::nullopt;
+            }
+            config.memoryBudget = static_cast<std::size_t>(megabytes) << 20;
+        } else if (arg == "--stream" && hasValue) {
+            const std::string spec = argv[++i];
+            const auto equals = spec.rfind('=');
+            InputStreamSpec stream;
+            bool valid = equals != std::string::npos && equals + 1 < spec.size();
+            if (valid) {
+                stream.device = spec.substr(0, equals);
+                if (stream.device == "default") {
+                    stream.device.clear();
+                }
+                std::size_t pos = equals + 1;
+                while (valid && pos <= spec.size()) {
+                    const std::size_t comma = std::min(spec.find(',', pos), spec.size());
+                    unsigned int scope = 0;
+                    const std::string index = spec.substr(pos, comma - pos);
+                    // Scope indices start at 0, which parseUnsigned rejects
+                    valid = !index.empty() && (index == "0" || parseUnsigned(index.c_str(), scope));
+                    stream.scopes.push_back(scope);
+                    pos = comma + 1;
+                }
+            }
+            if (!valid) {
+                std::cerr << "Error: Invalid stream spec (expected device=scope,...): " << spec << std::endl;
+                return std::nullopt;
+            }
+            config.inputStreams.push_back(stream);
+        } else if (arg == "--output" && hasValue) {
+            outputSpecs.push_back(argv[++i]);
+        } else if (arg == "--rt-selftest") {
+            config.rtSelfTest = true;
+        } else {
+            std::cerr << "Error: Unknown or incomplete option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return std::nullopt;
+        }
+    }
+
+    if (!config.recordPath.empty() && !config.replayPath.empty()) {
+        std::cerr << "Error: --record and --replay cannot be combined." << std::endl;
+        return std::nullopt;
+    }
+    if (!config.replayPath.empty() && config.inputSource == InputSource::Udp) {
+        std::cerr << "Error: --replay and --input udp cannot be combined." << std::endl;
+        return std::nullopt;
+    }
+
+    if (!config.inputStreams.empty() && (!config.replayPath.empty() || config.inputSource == InputSource::Udp)) {
+        std::cerr << "Error: --stream only applies to device input." << std::endl;
+        return std::nullopt;
+    }
+
+    for (const std::string& spec : outputSpecs) {
+        OutputSpec output;
+        if (!parseOutputSpec(spec, config.frameRateLimit, output)) {
+            std::cerr << "Error: Invalid output spec (expected kind:WxH[@fps][:scope,...]): " << spec << std::endl;
+            return std::nullopt;
+        }
+        config.outputs.push_back(output);
+    }
+    if (config.outputs.size() > kMaxOutputs) {
+        std::cerr << "Error: At most " << kMaxOutputs << " outputs are supported." << std::endl;
+        return std::nullopt;
+    }
+    if (config.outputs.empty()) {
+        OutputSpec output;
+        output.frameRate = config.frameRateLimit;
+        config.outputs.push_back(output);
+    }
+
+    return config;
+}
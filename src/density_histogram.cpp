@@ -0,0 +1,151 @@
+#include "include/density_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Counts below this are flushed to zero, which also keeps decay out of denormals
+constexpr float kDensityFloor = 1e-3f;
+
+// Bands per worker, so a band full of trace does not leave the others idle
+constexpr unsigned int kBandsPerWorker = 4;
+
+// Samples per binning task below which splitting costs more than it saves
+constexpr std::size_t kMinChunkFrames = 4096;
+
+} // namespace
+
+sf::Vector2u DensityHistogram::fitSize(const sf::Vector2u& target) {
+    const std::size_t pixelCount = static_cast<std::size_t>(target.x) * target.y;
+    if (pixelCount <= kMaxPixels) {
+        return target;
+    }
+    // Rounding both sides down keeps the product within the cap
+    const double scale = std::sqrt(static_cast<double>(kMaxPixels) / static_cast<double>(pixelCount));
+    return {std::max(1u, static_cast<unsigned int>(target.x * scale)),
+            std::max(1u, static_cast<unsigned int>(target.y * scale))};
+}
+
+void DensityHistogram::resize(const sf::Vector2u& target) {
+    m_size = fitSize(target);
+    const std::size_t pixelCount = static_cast<std::size_t>(m_size.x) * m_size.y;
+    m_density.assign(pixelCount, 0.f);
+    m_pixels.assign(pixelCount * 4, 0);
+    m_bands = 0; // Re-derived from the pool on the next update
+    m_normalization = 1.f;
+}
+
+void DensityHistogram::clear() {
+    std::fill(m_density.begin(), m_density.end(), 0.f);
+    std::fill(m_pixels.begin(), m_pixels.end(), 0);
+    m_normalization = 1.f;
+}
+
+void DensityHistogram::rebuildGammaTable(float gamma) {
+    m_gamma = gamma;
+    for (std::size_t i = 0; i < m_gammaTable.size(); ++i) {
+        m_gammaTable[i] = static_cast<std::uint8_t>(std::lround(255.f * std::pow(static_cast<float>(i) / 255.f, gamma)));
+    }
+}
+
+void DensityHistogram::update(const FrameRing& points, std::size_t count, const sf::Vector2f& pointOrigin, float pointScale, float decay, float gamma, sf::Color color,
+                              WorkerPool& pool) {
+    if (m_size.x == 0 || m_size.y == 0) {
+        return;
+    }
+    if (gamma != m_gamma) {
+        rebuildGammaTable(gamma);
+    }
+    const unsigned int workers = pool.size();
+    if (m_bands == 0) {
+        m_bands = std::min(workers * kBandsPerWorker, m_size.y);
+        m_rowsPerBand = (m_size.y + m_bands - 1) / m_bands;
+        m_bands = (m_size.y + m_rowsPerBand - 1) / m_rowsPerBand;
+        m_bandEnd.assign(static_cast<std::size_t>(workers) * m_bands, 0);
+        m_bandPeak.assign(m_bands, 0.f);
+    }
+
+    // Phase 1: each chunk of new samples counting-sorts its pixel hits by band,
+    // within its own range of m_hits, so binning never needs more than count entries
+    const std::size_t chunks = std::clamp<std::size_t>(count / kMinChunkFrames, 1, workers);
+    const std::size_t chunkFrames = (count + chunks - 1) / chunks;
+    const float width = static_cast<float>(m_size.x);
+    const float height = static_cast<float>(m_size.y);
+    const std::uint32_t bandPixels = m_rowsPerBand * m_size.x;
+    m_unsorted.resize(count);
+    m_hits.resize(count);
+    pool.parallelFor(chunks, [&](std::size_t chunk) {
+        std::size_t* bandEnd = &m_bandEnd[chunk * m_bands];
+        std::fill(bandEnd, bandEnd + m_bands, 0);
+        const std::size_t begin = chunk * chunkFrames;
+        const std::size_t end = std::min(count, begin + chunkFrames);
+        std::size_t hits = begin;
+        for (std::size_t i = begin; i < end; ++i) {
+            const float* p = points.frame(i);
+            const float px = (p[0] - pointOrigin.x) * pointScale;
+            const float py = (p[1] - pointOrigin.y) * pointScale;
+            // Points off the texture (e.g. queued before a resize) are dropped
+            if (!(px >= 0.f && px < width && py >= 0.f && py < height)) {
+                continue;
+            }
+            const auto x = static_cast<std::uint32_t>(px);
+            const auto y = static_cast<std::uint32_t>(py);
+            const std::uint32_t pixel = y * m_size.x + x;
+            m_unsorted[hits++] = pixel;
+            ++bandEnd[pixel / bandPixels];
+        }
+        // Counts to band starts; the scatter then advances each to its band's end
+        std::size_t start = begin;
+        for (unsigned int band = 0; band < m_bands; ++band) {
+            start += std::exchange(bandEnd[band], start);
+        }
+        for (std::size_t i = begin; i < hits; ++i) {
+            m_hits[bandEnd[m_unsorted[i] / bandPixels]++] = m_unsorted[i];
+        }
+    });
+
+    // Phase 2: each band adds every chunk's hits, then decays and maps its own pixels.
+    // Intensity is normalized by the previous update's peak, so one pass suffices
+    const float normalization = m_normalization;
+    const float logNormalization = std::log1p(normalization);
+    const std::uint8_t r = color.r;
+    const std::uint8_t g = color.g;
+    const std::uint8_t b = color.b;
+    const float alphaScale = static_cast<float>(color.a) / 255.f;
+    pool.parallelFor(m_bands, [&](std::size_t band) {
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            const std::size_t* bandEnd = &m_bandEnd[chunk * m_bands];
+            const std::size_t from = band == 0 ? chunk * chunkFrames : bandEnd[band - 1];
+            for (std::size_t i = from; i < bandEnd[band]; ++i) {
+                m_density[m_hits[i]] += 1.f;
+            }
+        }
+
+        const std::size_t begin = band * m_rowsPerBand * static_cast<std::size_t>(m_size.x);
+        const std::size_t end = std::min<std::size_t>((band + 1) * m_rowsPerBand, m_size.y) * m_size.x;
+        float peak = 0.f;
+        for (std::size_t i = begin; i < end; ++i) {
+            const float v = m_density[i];
+            peak = std::max(peak, v);
+            std::uint8_t* out = &m_pixels[4 * i];
+            if (v == 0.f) {
+                out[3] = 0;
+                continue;
+            }
+            const float level = std::min(std::log1p(v) / logNormalization, 1.f);
+            out[0] = r;
+            out[1] = g;
+            out[2] = b;
+            out[3] = static_cast<std::uint8_t>(m_gammaTable[static_cast<std::size_t>(level * 255.f)] * alphaScale);
+            const float decayed = v * decay;
+            m_density[i] = decayed < kDensityFloor ? 0.f : decayed;
+        }
+        m_bandPeak[band] = peak;
+    });
+
+    // Release eight times slower than the counts decay, so a stopped signal visibly fades
+    const float peak = *std::max_element(m_bandPeak.begin(), m_bandPeak.end());
+    m_normalization = std::max({peak, m_normalization * std::pow(decay, 0.125f), 1.f});
+}
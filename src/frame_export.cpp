@@ -0,0 +1,115 @@
+#define GL_GLEXT_PROTOTYPES
+#include "include/frame_export.hpp"
+#include <SFML/OpenGL.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+FrameExporter::FrameExporter(std::string shmName, unsigned int slotCount)
+    : m_name(std::move(shmName)), m_slotCount(std::max(slotCount, 2u)),
+      m_lastReport(std::chrono::steady_clock::now()) {
+}
+
+FrameExporter::~FrameExporter() {
+    if (m_pbos[0] != 0) {
+        glDeleteBuffers(static_cast<GLsizei>(m_pbos.size()), m_pbos.data());
+    }
+}
+
+void FrameExporter::openRing(const sf::Vector2u& size, std::chrono::steady_clock::time_point now) {
+    const std::size_t frameBytes = static_cast<std::size_t>(size.x) * size.y * 4;
+    if (m_ring.create(m_name, m_slotCount, frameBytes)) {
+        std::cout << "Export: publishing " << size.x << "x" << size.y << " RGBA frames to shared memory "
+                  << m_name << " (" << m_slotCount << " slots)" << std::endl;
+        m_retryDelay = std::chrono::seconds(1);
+        return;
+    }
+    // Keep trying, so one transient shm_open or ftruncate failure does not end export for the session
+    std::cerr << "Export: no frames published to " << m_name << ", retrying in " << m_retryDelay.count() << " s"
+              << std::endl;
+    m_retryAt = now + m_retryDelay;
+    m_retryDelay = std::min(m_retryDelay * 2, kMaxRetryDelay);
+}
+
+void FrameExporter::allocate(const sf::Vector2u& size) {
+    const std::size_t frameBytes = static_cast<std::size_t>(size.x) * size.y * 4;
+
+    if (m_pbos[0] == 0) {
+        glGenBuffers(static_cast<GLsizei>(m_pbos.size()), m_pbos.data());
+    }
+    for (unsigned int pbo : m_pbos) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(frameBytes), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_size = size;
+    m_pending = false;
+}
+
+void FrameExporter::capture(sf::RenderTexture& composite) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t timestamp = shmframe::nowNs();
+
+    if (!composite.setActive(true)) {
+        return;
+    }
+    const sf::Vector2u size = composite.getSize();
+    if (size != m_size) {
+        allocate(size);
+        m_retryAt = {};
+    }
+    const std::size_t frameBytes = static_cast<std::size_t>(size.x) * size.y * 4;
+    if ((!m_ring.isOpen() || frameBytes > m_ring.maxFrameBytes()) && start >= m_retryAt) {
+        openRing(size, start);
+    }
+    if (!m_ring.isOpen()) {
+        return;
+    }
+
+    const unsigned int writeIndex = m_readIndex ^ 1u;
+
+    // Queue this frame's transfer; it completes while the next frame renders
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[writeIndex]);
+    glReadPixels(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_timestamps[writeIndex] = timestamp;
+
+    // Publish the previous frame straight from the mapped buffer into the ring
+    if (m_pending) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[m_readIndex]);
+        if (const void* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)) {
+            const std::uint32_t stride = size.x * 4;
+            std::memcpy(m_ring.beginFrame(), pixels, static_cast<std::size_t>(stride) * size.y);
+            m_ring.commitFrame(m_timestamps[m_readIndex], size.x, size.y, stride,
+                               shmframe::PixelFormat::RGBA8, shmframe::kFlagBottomUp);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_pending = true;
+    m_readIndex = writeIndex;
+
+    const auto end = std::chrono::steady_clock::now();
+    const double overheadMs = std::chrono::duration<double, std::milli>(end - start).count();
+    m_totalOverheadMs += overheadMs;
+    m_maxOverheadMs = std::max(m_maxOverheadMs, overheadMs);
+    ++m_frames;
+    if (end - m_lastReport >= std::chrono::seconds(1)) {
+        report(end);
+    }
+}
+
+void FrameExporter::report(std::chrono::steady_clock::time_point now) {
+    if (m_frames > 0) {
+        std::cout << "Export: " << m_frames << " frames to " << m_name << ", overhead per frame "
+                  << "mean " << m_totalOverheadMs / m_frames << " ms, "
+                  << "max " << m_maxOverheadMs << " ms" << std::endl;
+    }
+    m_totalOverheadMs = 0.0;
+    m_maxOverheadMs = 0.0;
+    m_frames = 0;
+    m_lastReport = now;
+}
@@ -0,0 +1,41 @@
+#include "include/frame_ring.hpp"
+
+namespace {
+
+std::size_t nextPowerOfTwo(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+} // namespace
+
+FrameRing::FrameRing(std::size_t frames, unsigned int channels)
+    : m_data(nextPowerOfTwo(frames) * channels), m_mask(nextPowerOfTwo(frames) - 1), m_channels(channels) {
+}
+
+float* FrameRing::beginPush() {
+    if (m_pending - m_tail.load(std::memory_order_acquire) > m_mask) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return m_data.data() + (m_pending++ & m_mask) * m_channels;
+}
+
+void FrameRing::commitPush() {
+    m_head.store(m_pending, std::memory_order_release);
+}
+
+std::size_t FrameRing::available() const {
+    return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+}
+
+const float* FrameRing::frame(std::size_t i) const {
+    return m_data.data() + ((m_tail.load(std::memory_order_relaxed) + i) & m_mask) * m_channels;
+}
+
+void FrameRing::consume(std::size_t n) {
+    m_tail.store(m_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
@@ -0,0 +1,145 @@
+#ifndef BUFFER_TUNER_HPP
+#define BUFFER_TUNER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class BufferTuner
+ * @brief Picks the smallest audio buffer size the callback keeps up with.
+ *
+ * The audio callback reports how long each call took; the control thread
+ * calls evaluate() periodically. Every window, the tuner takes a high
+ * quantile of the processing times and recommends the smallest power-of-two
+ * buffer whose period leaves the configured margin free. Much of the
+ * callback's cost does not depend on the buffer size (the trace strip is
+ * rebuilt once per block), so other sizes are predicted with a line through
+ * the peaks recently measured at two sizes, or as costing the same when
+ * only one size has been measured. The buffer grows at once, one doubling
+ * per window; shrinking waits for two windows in a row. A size that
+ * overloaded, or that the backend refused, is not tried again for a minute.
+ */
+class BufferTuner {
+public:
+    static constexpr unsigned int kMinFrames = 32;
+    static constexpr unsigned int kMaxFrames = 4096;
+
+    /**
+     * @struct Report
+     * @brief Measurements of one window and what the tuner made of them.
+     */
+    struct Report {
+        unsigned int bufferFrames = 0;
+        double periodMs = 0.0;
+        double medianMs = 0.0;
+        double peakMs = 0.0;            ///< 99.9th percentile of the callback time
+        double margin = 0.0;            ///< Share of the period left free at the peak
+        std::uint64_t callbacks = 0;
+        std::uint64_t overflows = 0;
+        unsigned int recommendedFrames = 0;
+        bool reopen = false;            ///< Reopen the stream at recommendedFrames
+    };
+
+    /**
+     * @param margin Share of the buffer period the callback must leave free (0 to 0.95).
+     */
+    explicit BufferTuner(double margin = 0.5);
+
+    /**
+     * @brief Sets the share of the period the callback must leave free.
+     */
+    void setMargin(double margin);
+
+    /**
+     * @brief Gets the required margin.
+     */
+    double margin() const { return m_margin; }
+
+    /**
+     * @brief Starts measuring a newly (re)opened stream. Control thread.
+     * @param bufferFrames Buffer size the stream actually got.
+     * @param sampleRate Stream sample rate.
+     * @param sizeFixed True if the backend dictates the size (e.g. the JACK
+     * period); the tuner then only reports.
+     * @param now Current time.
+     */
+    void start(unsigned int bufferFrames, unsigned int sampleRate, bool sizeFixed,
+               std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Holds off a size the backend refused to open, for as long as an overloaded
+     * size is held off. Call after start() for the stream that was reopened instead. Control thread.
+     * @param frames Buffer size that could not be opened.
+     * @param now Current time.
+     */
+    void rejectSize(unsigned int frames, std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Records one callback. Realtime-safe: never allocates, locks or blocks.
+     * @param processing Time the callback took.
+     * @param overflow True if the backend reported an input overflow.
+     */
+    void recordCallback(std::chrono::nanoseconds processing, bool overflow);
+
+    /**
+     * @brief Discards the current window, e.g. after the scope load changed,
+     * so the next decision only sees the new load. Control thread.
+     */
+    void noteLoadChange(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Closes the window once it is long enough. Control thread.
+     * @return True if a window closed; report() then holds its results.
+     */
+    bool evaluate(std::chrono::steady_clock::time_point now);
+
+    /**
+     * @brief Results of the last closed window.
+     */
+    const Report& report() const { return m_report; }
+
+    /**
+     * @brief Whether the stream's buffer size can be changed.
+     */
+    bool sizeFixed() const { return m_sizeFixed; }
+
+private:
+    // Callback times in 8 buckets per octave, from 1 us to about 1 s
+    static constexpr int kBucketsPerOctave = 8;
+    static constexpr std::size_t kBuckets = 20 * kBucketsPerOctave;
+
+    static std::size_t bucketOf(std::chrono::nanoseconds processing);
+    static double bucketLimitMs(std::size_t bucket);
+    void resetWindow(std::chrono::steady_clock::time_point now);
+    double predictPeakMs(unsigned int frames, double peakMs, std::chrono::steady_clock::time_point now) const;
+
+    // Peak callback time last measured at each power-of-two size from kMinFrames up
+    struct SizeSample {
+        double peakMs = 0.0;
+        std::chrono::steady_clock::time_point at{};
+    };
+    static constexpr std::size_t kSizes = 8;
+
+    // Written by the audio thread
+    std::array<std::atomic<std::uint32_t>, kBuckets> m_histogram{};
+    std::atomic<std::uint64_t> m_overflows{0};
+
+    // Control thread
+    double m_margin;
+    unsigned int m_bufferFrames = 256;
+    unsigned int m_sampleRate = 48000;
+    bool m_sizeFixed = false;
+    std::chrono::steady_clock::time_point m_windowStart{};
+    unsigned int m_shrinkVotes = 0;
+    unsigned int m_floorFrames = kMinFrames;
+    std::chrono::steady_clock::time_point m_floorUntil{};
+    unsigned int m_ceilingFrames = kMaxFrames;
+    std::chrono::steady_clock::time_point m_ceilingUntil{};
+    std::array<SizeSample, kSizes> m_sizeSamples{};
+    Report m_report;
+};
+
+#endif // BUFFER_TUNER_HPP
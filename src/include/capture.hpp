@@ -0,0 +1,224 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sample_format.hpp"
+
+/**
+ * On-disk layout of a capture file: a CaptureFileHeader followed by records.
+ * The header holds the audio's sample rate; the recorder fills it in when it
+ * stops, so it is 0 in files that were never closed and in version 1 files. Each record is a CaptureRecordHeader and `size` payload bytes, padded to
+ * 8 bytes. Audio payloads start with an AudioBlockHeader followed by the raw
+ * interleaved samples in the input's SampleFormat; OSC payloads are the
+ * packet exactly as received. Timestamps are nanoseconds since the recording started.
+ */
+namespace capture {
+
+constexpr char kMagic[8] = {'O', 'S', 'C', 'A', 'R', 'C', 'A', 'P'};
+constexpr std::uint32_t kVersion = 2;
+// Files from before the header carried the sample rate; they replay with it unknown
+constexpr std::uint32_t kMinVersion = 1;
+
+enum class RecordType : std::uint32_t {
+    Audio = 1,
+    Osc = 2
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t sampleRate; // Of the audio blocks, 0 if unknown
+};
+
+struct CaptureRecordHeader {
+    RecordType type;
+    std::uint32_t size;
+    std::uint64_t timestampNs;
+};
+
+struct AudioBlockHeader {
+    std::uint32_t nFrames;
+    std::uint16_t nChannels;
+    SampleFormat format;
+    double streamTime;
+};
+
+static_assert(sizeof(CaptureRecordHeader) == 16 && sizeof(AudioBlockHeader) == 16, "Capture records are 8-byte aligned");
+
+/**
+ * @class ByteRing
+ * @brief Preallocated single-producer/single-consumer ring of variable-sized records.
+ *
+ * push() never allocates, locks or blocks; a record that does not fit is
+ * dropped and counted instead.
+ */
+class ByteRing {
+public:
+    /**
+     * @param capacity Bytes of storage, rounded up to a power of two.
+     */
+    explicit ByteRing(std::size_t capacity);
+
+    /**
+     * @brief Appends one record; its payload is prefix followed by body.
+     * header.size must equal prefixBytes + bodyBytes.
+     * @return False if the ring was too full (the record is dropped).
+     */
+    bool push(const CaptureRecordHeader& header, const void* prefix, std::size_t prefixBytes,
+              const void* body, std::size_t bodyBytes);
+
+    /**
+     * @brief Reads the header of the oldest record without consuming it.
+     * @return False if the ring is empty.
+     */
+    bool peek(CaptureRecordHeader& header) const;
+
+    /**
+     * @brief Consumes the oldest record, copying its payload.
+     * @param payload Destination of at least header.size bytes.
+     */
+    void pop(const CaptureRecordHeader& header, void* payload);
+
+    std::uint64_t droppedRecords() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void copyIn(std::size_t pos, const void* src, std::size_t n);
+    void copyOut(std::size_t pos, void* dst, std::size_t n) const;
+
+    std::vector<std::uint8_t> m_data;
+    std::size_t m_mask;
+    std::atomic<std::size_t> m_head{0}; // Written by the producer
+    std::atomic<std::size_t> m_tail{0}; // Written by the consumer
+    std::atomic<std::uint64_t> m_dropped{0};
+};
+
+/**
+ * @class CaptureRecorder
+ * @brief Streams audio blocks and OSC packets to an append-only capture file.
+ *
+ * The audio callback and the OSC thread each push into their own
+ * preallocated ring; a background thread merges both by timestamp and
+ * writes them out, so neither producer ever touches the file.
+ */
+class CaptureRecorder {
+public:
+    CaptureRecorder() = default;
+    ~CaptureRecorder();
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    /**
+     * @brief Opens the file and starts the writer thread.
+     * @param path Output file (truncated).
+     * @param audioRingBytes Ring size for audio blocks.
+     * @param oscRingBytes Ring size for OSC packets.
+     * @return False if the file could not be opened.
+     */
+    bool start(const std::string& path, std::size_t audioRingBytes, std::size_t oscRingBytes);
+
+    /**
+     * @brief Drains the rings, closes the file and prints a summary.
+     */
+    void stop();
+
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Sets the sample rate stored in the file header. May be called from any thread,
+     * before or during recording; the rate set last is the one written when the recording stops.
+     */
+    void setSampleRate(unsigned int rate) { m_sampleRate.store(rate, std::memory_order_relaxed); }
+
+    /**
+     * @brief Records one interleaved block. Realtime-safe.
+     */
+    void recordAudio(const void* samples, SampleFormat format, unsigned int nFrames, unsigned int nChannels, double streamTime);
+
+    /**
+     * @brief Records one raw OSC packet. Call from a single (network) thread.
+     */
+    void recordOsc(const char* data, std::size_t size);
+
+private:
+    std::uint64_t elapsedNs() const;
+    void writeHeader();
+    void writerLoop();
+    bool writeNext();
+
+    std::atomic<bool> m_recording{false};
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<unsigned int> m_sampleRate{0};
+    std::chrono::steady_clock::time_point m_startTime;
+    std::FILE* m_file = nullptr;
+    std::string m_path;
+    std::unique_ptr<ByteRing> m_audioRing;
+    std::unique_ptr<ByteRing> m_oscRing;
+    std::vector<std::uint8_t> m_scratch;
+    std::vector<char> m_fileBuffer;
+    std::thread m_writer;
+    std::uint64_t m_audioRecords = 0;
+    std::uint64_t m_oscRecords = 0;
+};
+
+/**
+ * @brief How fast a capture is fed back.
+ */
+enum class ReplaySpeed {
+    Realtime,      ///< Honour the recorded timestamps.
+    AsFastAsPossible
+};
+
+/**
+ * @class CaptureReplayer
+ * @brief Memory-maps a capture file and feeds its records back in order.
+ */
+class CaptureReplayer {
+public:
+    using AudioSink = std::function<void(const void* samples, SampleFormat format, unsigned int nFrames,
+                                         unsigned int nChannels, double streamTime)>;
+    using OscSink = std::function<void(const char* data, std::size_t size)>;
+
+    CaptureReplayer() = default;
+    ~CaptureReplayer();
+    CaptureReplayer(const CaptureReplayer&) = delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+
+    /**
+     * @brief Maps the capture file and validates its header.
+     * @return False if the file is missing or not a capture.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Feeds every record to the sinks on the calling thread.
+     * @param speed Realtime or as fast as possible.
+     * @param stop Checked between records; replay ends early once set.
+     * @return True if the whole file was replayed.
+     */
+    bool run(ReplaySpeed speed, const AudioSink& audio, const OscSink& osc, const std::atomic<bool>& stop);
+
+    /**
+     * @brief Sample rate of the recorded audio, or 0 if the file does not say.
+     */
+    unsigned int sampleRate() const { return m_sampleRate; }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::string m_path;
+    unsigned int m_sampleRate = 0;
+};
+
+} // namespace capture
+
+#endif // CAPTURE_HPP
@@ -0,0 +1,73 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "capture.hpp"
+#include "render_output.hpp"
+
+/**
+ * @brief How the render thread paces presented frames.
+ */
+enum class FramePacing {
+    VSync,     ///< Block in display() until the next vertical blank.
+    Limit,     ///< Sleep to hold a fixed frame rate (SFML framerate limit).
+    Unlimited  ///< Present as fast as frames can be rendered.
+};
+
+/**
+ * @brief Where live audio comes from.
+ */
+enum class InputSource {
+    Device, ///< RtAudio (JACK on Linux, BlackHole on macOS).
+    Udp     ///< PCM stream over UDP (see udp_audio.hpp).
+};
+
+/**
+ * @struct InputStreamSpec
+ * @brief One audio device stream and the scopes it feeds (--stream).
+ */
+struct InputStreamSpec {
+    std::string device;               // Substring of the device name; empty for the default input
+    std::vector<unsigned int> scopes; // Channel pair k of the stream feeds scopes[k]
+};
+
+/**
+ * @struct RenderConfig
+ * @brief Runtime options taken from the command line.
+ */
+struct RenderConfig {
+    FramePacing framePacing = FramePacing::Limit;
+    unsigned int frameRateLimit = 60;
+    std::optional<double> targetFrameMs; // Unset: one frame at frameRateLimit
+    bool lockQuality = false;         // Keep full quality instead of degrading under load
+    bool measureLatency = false;
+    std::string exportShmName;        // Empty disables shared-memory frame export
+    unsigned int exportSlotCount = 3;
+    std::string recordPath;           // Capture audio and OSC to this file
+    std::string replayPath;           // Feed a capture instead of live audio and OSC
+    capture::ReplaySpeed replaySpeed = capture::ReplaySpeed::Realtime;
+    InputSource inputSource = InputSource::Device;
+    unsigned int udpPort = 7001;
+    std::optional<SampleFormat> sampleFormat; // Unset: the device's native format
+    unsigned int bufferFrames = 256;  // Requested device buffer size; JACK uses its own period
+    bool tuneLatency = false;         // Adapt the buffer size to the measured callback time
+    double latencyMargin = 0.5;       // Share of the buffer period the callback must leave free
+    std::size_t memoryBudget = std::size_t(256) << 20; // Bytes for all scope history and geometry
+    std::vector<InputStreamSpec> inputStreams; // Empty: one stream feeding every scope
+    std::vector<OutputSpec> outputs;  // Never empty after parsing: one window by default
+    bool rtSelfTest = false;          // Run the headless realtime-safety test and exit
+};
+
+/**
+ * @brief Parses command-line options.
+ * @param argc Argument count from main().
+ * @param argv Argument vector from main().
+ * @return Parsed config, or std::nullopt if the program should exit.
+ */
+std::optional<RenderConfig> parseCommandLine(int argc, char* argv[]);
+
+#endif // CONFIG_HPP
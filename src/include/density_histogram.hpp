@@ -0,0 +1,100 @@
+#ifndef DENSITY_HISTOGRAM_HPP
+#define DENSITY_HISTOGRAM_HPP
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame_ring.hpp"
+#include "worker_pool.hpp"
+
+/**
+ * @class DensityHistogram
+ * @brief Decaying per-pixel hit counts of a scope's samples, mapped to RGBA.
+ *
+ * Each update bins only the samples that arrived since the last one, then
+ * makes one pass over the pixels that decays the counts and maps them to
+ * color. The cost does not depend on how long the visible history is.
+ *
+ * Binning runs on a WorkerPool without atomics: workers first sort their
+ * share of the samples by band into runs of pixel indices, then each worker
+ * owns one horizontal band of the image and adds up every run for it before
+ * decaying and mapping the band.
+ *
+ * The resolution is capped at kMaxPixels, so the memory a histogram can hold
+ * is fixed and can be reserved before the scope ever enters density mode.
+ */
+class DensityHistogram {
+public:
+    // Largest histogram; bigger targets are binned at a lower resolution and scaled up
+    static constexpr std::size_t kMaxPixels = std::size_t(1) << 20;
+
+    /**
+     * @brief Histogram size for a target: the target itself, or scaled down to kMaxPixels keeping its aspect.
+     */
+    static sf::Vector2u fitSize(const sf::Vector2u& target);
+
+    /**
+     * @brief Most memory a histogram and its texture can hold: counts, RGBA pixels and texels
+     * at kMaxPixels, plus the pixel indices of one update, before and after sorting.
+     * @param maxPoints Most samples binned in one update.
+     */
+    static constexpr std::size_t maxBytes(std::size_t maxPoints) {
+        return kMaxPixels * (sizeof(float) + 4 + 4) + 2 * maxPoints * sizeof(std::uint32_t);
+    }
+
+    /**
+     * @brief Sets the pixel size to fitSize(target) and clears the histogram.
+     */
+    void resize(const sf::Vector2u& target);
+
+    /**
+     * @brief Clears the histogram, e.g. when the scope enters density mode.
+     */
+    void clear();
+
+    /**
+     * @brief Bins new samples, decays older ones and remaps the pixels.
+     * @param points Screen positions (x, y), 2 floats per frame.
+     * @param count Frames of points to bin, at most points.available().
+     * @param pointOrigin Point coordinates of the histogram's top-left corner.
+     * @param pointScale Histogram pixels per point unit.
+     * @param decay Factor the existing counts are multiplied by.
+     * @param gamma Exponent of the intensity curve after log compression.
+     * @param color Trace color; its alpha scales the whole image.
+     */
+    void update(const FrameRing& points, std::size_t count, const sf::Vector2f& pointOrigin, float pointScale, float decay, float gamma, sf::Color color,
+                WorkerPool& pool);
+
+    const sf::Vector2u& size() const { return m_size; }
+
+    /**
+     * @brief RGBA pixels, row-major, top row first.
+     */
+    const std::uint8_t* pixels() const { return m_pixels.data(); }
+
+private:
+    void rebuildGammaTable(float gamma);
+
+    sf::Vector2u m_size{0, 0};
+    std::vector<float> m_density;
+    std::vector<std::uint8_t> m_pixels;
+
+    // Pixel indices the new samples hit; chunk c's run for band b ends at
+    // m_bandEnd[c * m_bands + b] and starts where its run for band b - 1 ends
+    std::vector<std::uint32_t> m_unsorted;
+    std::vector<std::uint32_t> m_hits;
+    std::vector<std::size_t> m_bandEnd;
+    unsigned int m_bands = 0;
+    unsigned int m_rowsPerBand = 1;
+    std::vector<float> m_bandPeak;
+
+    // Count that maps to full intensity; follows the peak up at once and down slowly
+    float m_normalization = 1.f;
+    float m_gamma = 0.f;
+    std::array<std::uint8_t, 256> m_gammaTable{};
+};
+
+#endif // DENSITY_HISTOGRAM_HPP
@@ -0,0 +1,64 @@
+#ifndef FRAME_EXPORT_HPP
+#define FRAME_EXPORT_HPP
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <string>
+
+#include "shm_frame.hpp"
+
+/**
+ * @class FrameExporter
+ * @brief Publishes rendered frames into a shared-memory ring for local consumers.
+ *
+ * Readback is double buffered through pixel buffer objects: each frame
+ * queues an asynchronous glReadPixels into one PBO and maps the other, which
+ * was filled on the previous frame, so the render thread never waits for the
+ * transfer. Exported frames therefore trail the display by one frame.
+ * Must only be used from the render thread.
+ */
+class FrameExporter {
+public:
+    /**
+     * @param shmName POSIX shared memory name, e.g. "/oscar".
+     * @param slotCount Number of frames kept in the ring.
+     */
+    FrameExporter(std::string shmName, unsigned int slotCount);
+    ~FrameExporter();
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    /**
+     * @brief Queues readback of the finished composite and publishes the previous one.
+     * @param composite Render texture holding the final frame (display() already called).
+     */
+    void capture(sf::RenderTexture& composite);
+
+private:
+    void allocate(const sf::Vector2u& size);
+    void openRing(const sf::Vector2u& size, std::chrono::steady_clock::time_point now);
+    void report(std::chrono::steady_clock::time_point now);
+
+    std::string m_name;
+    unsigned int m_slotCount;
+    shmframe::FrameRingWriter m_ring;
+    // A ring that could not be created is retried, backing off up to kMaxRetryDelay
+    static constexpr std::chrono::seconds kMaxRetryDelay{30};
+    std::chrono::steady_clock::time_point m_retryAt;
+    std::chrono::seconds m_retryDelay{1};
+
+    std::array<unsigned int, 2> m_pbos{};
+    std::array<std::uint64_t, 2> m_timestamps{};
+    unsigned int m_readIndex = 0;
+    bool m_pending = false;
+    sf::Vector2u m_size{0, 0};
+
+    // Export overhead statistics
+    std::chrono::steady_clock::time_point m_lastReport;
+    double m_totalOverheadMs = 0.0;
+    double m_maxOverheadMs = 0.0;
+    unsigned int m_frames = 0;
+};
+
+#endif // FRAME_EXPORT_HPP
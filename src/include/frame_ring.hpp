@@ -0,0 +1,64 @@
+#ifndef FRAME_RING_HPP
+#define FRAME_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class FrameRing
+ * @brief Preallocated single-producer/single-consumer ring of interleaved float frames.
+ *
+ * push() never allocates, locks or blocks; frames that do not fit are dropped
+ * and counted instead.
+ */
+class FrameRing {
+public:
+    /**
+     * @param frames Capacity in frames, rounded up to a power of two.
+     * @param channels Floats per frame.
+     */
+    FrameRing(std::size_t frames, unsigned int channels);
+
+    /**
+     * @brief Producer: appends one frame, converted by the caller into the returned slot.
+     * @return Slot of channels() floats, or nullptr if the ring is full.
+     */
+    float* beginPush();
+
+    /**
+     * @brief Producer: publishes all frames written since the last commit.
+     */
+    void commitPush();
+
+    /**
+     * @brief Consumer: frames ready to be read.
+     */
+    std::size_t available() const;
+
+    /**
+     * @brief Consumer: the i-th unread frame, i < available().
+     */
+    const float* frame(std::size_t i) const;
+
+    /**
+     * @brief Consumer: releases the n oldest frames.
+     */
+    void consume(std::size_t n);
+
+    std::size_t capacity() const { return m_mask + 1; }
+    unsigned int channels() const { return m_channels; }
+    std::uint64_t droppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<float> m_data;
+    std::size_t m_mask;
+    unsigned int m_channels;
+    std::size_t m_pending = 0;              // Producer-local: head including unpublished frames
+    std::atomic<std::size_t> m_head{0};     // Written by the producer
+    std::atomic<std::size_t> m_tail{0};     // Written by the consumer
+    std::atomic<std::uint64_t> m_dropped{0};
+};
+
+#endif // FRAME_RING_HPP
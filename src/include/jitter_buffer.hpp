@@ -0,0 +1,136 @@
+#ifndef JITTER_BUFFER_HPP
+#define JITTER_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class JitterBuffer
+ * @brief Reorders, delays and re-clocks a stream of fixed-size PCM packets.
+ *
+ * Packets are placed by sequence number into a ring. Playout runs on the
+ * local clock and lags the newest packet by a target delay that adapts to
+ * the measured interarrival jitter (the RFC 3550 estimator). Missing packets
+ * are concealed by repeating the last good packet with a fade. Clock drift
+ * between sender and receiver is absorbed by playing slightly faster or
+ * slower (linear interpolation) to hold the buffer level at the target.
+ *
+ * The first packet fixes the stream format. Packets of another format are
+ * dropped, unless nothing but that format has arrived for half a second
+ * (the sender was restarted with new settings); the buffer then re-syncs
+ * to it.
+ *
+ * Not thread-safe: push() and pull() must be called from the same thread.
+ * pull() never allocates; push() only allocates when the stream re-syncs.
+ */
+class JitterBuffer {
+public:
+    struct Stats {
+        std::uint64_t received = 0;
+        std::uint64_t lost = 0;           ///< Packets that had not arrived when played
+        std::uint64_t late = 0;           ///< Packets that arrived after being played
+        std::uint64_t duplicates = 0;
+        std::uint64_t foreign = 0;        ///< Packets dropped for a format other than the stream's
+        std::uint64_t concealedFrames = 0;
+        std::uint64_t underruns = 0;      ///< Times playout caught up with the newest packet
+        double jitterMs = 0.0;            ///< RFC 3550 interarrival jitter
+        double targetMs = 0.0;
+        double levelMs = 0.0;             ///< Buffered audio ahead of the playout position
+        double rateRatio = 1.0;           ///< Input frames consumed per output frame
+    };
+
+    /**
+     * @param outputChannels Channels written by pull(); extra input channels are dropped, missing ones zeroed.
+     * @param minDelayMs Lower bound of the adaptive target delay.
+     * @param maxDelayMs Upper bound of the adaptive target delay.
+     */
+    JitterBuffer(unsigned int outputChannels, double minDelayMs, double maxDelayMs);
+
+    /**
+     * @brief Adds one packet.
+     * @param sequence Packet sequence number (wraps at 2^32).
+     * @param senderTimeNs Sender clock at the packet's first frame.
+     * @param samples Interleaved int16 samples.
+     * @param arrivalNs Local clock when the packet arrived.
+     */
+    void push(std::uint32_t sequence, std::uint64_t senderTimeNs, const std::int16_t* samples,
+              unsigned int nFrames, unsigned int nChannels, unsigned int sampleRate, std::uint64_t arrivalNs);
+
+    /**
+     * @brief Produces nFrames of interleaved output, concealing any gaps.
+     * @param senderTimeNs Set to the sender time of the first output frame, or 0 if it was concealed.
+     * @return False (and nothing written) until the first packet has been buffered.
+     */
+    bool pull(std::int16_t* out, unsigned int nFrames, std::uint64_t& senderTimeNs);
+
+    /**
+     * @brief Sample rate of the incoming stream, or 0 before the first packet.
+     */
+    unsigned int sampleRate() const { return m_sampleRate; }
+
+    /**
+     * @brief Current counters and estimates. Counters are reset by resetCounters().
+     */
+    Stats stats() const;
+    void resetCounters();
+
+private:
+    struct Slot {
+        std::uint64_t packet = ~0ull;     // Extended sequence number held, or ~0 if empty
+        std::uint64_t senderTimeNs = 0;
+    };
+
+    void reset(unsigned int nFrames, unsigned int nChannels, unsigned int sampleRate);
+    std::uint64_t extendSequence(std::uint32_t sequence) const;
+    const Slot* find(std::uint64_t packet) const;
+    const std::int16_t* slotSamples(const Slot& slot) const;
+    bool fetchFrame(std::uint64_t frame, float* out) const;
+    void conceal(float* out);
+    void updateTarget();
+    double levelFrames() const;
+    void updateRate(unsigned int nFrames);
+
+    unsigned int m_outputChannels;
+    double m_minDelayMs;
+    double m_maxDelayMs;
+
+    // Stream format, fixed by the first packet
+    unsigned int m_packetFrames = 0;
+    unsigned int m_inputChannels = 0;
+    unsigned int m_sampleRate = 0;
+    unsigned int m_pullFrames = 0;        // Output block size, part of the minimum delay
+
+    // A different format seen since the last packet of the stream's own, and when it was first seen
+    unsigned int m_nextPacketFrames = 0;
+    unsigned int m_nextChannels = 0;
+    unsigned int m_nextSampleRate = 0;
+    std::uint64_t m_nextFormatSinceNs = 0;
+
+    std::vector<Slot> m_slots;
+    std::vector<std::int16_t> m_samples;
+    std::vector<float> m_frameA;
+    std::vector<float> m_frameB;
+
+    bool m_started = false;
+    bool m_buffering = true;
+    bool m_played = false;
+    std::uint64_t m_highestPacket = 0;
+    std::uint64_t m_lastGoodPacket = ~0ull;
+    std::uint64_t m_lastCheckedPacket = ~0ull;
+    double m_readPos = 0.0;               // Playout position in stream frames
+    std::uint64_t m_concealRun = 0;       // Consecutive concealed output frames
+
+    // Delay and drift control
+    bool m_haveTransit = false;
+    double m_lastTransitNs = 0.0;
+    double m_jitterNs = 0.0;
+    double m_targetFrames = 0.0;
+    double m_levelAverage = 0.0;
+    double m_rateIntegral = 0.0;
+    double m_rate = 1.0;
+
+    Stats m_counters;
+};
+
+#endif // JITTER_BUFFER_HPP
@@ -0,0 +1,43 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @class LatencyMonitor
+ * @brief Tracks the age of the newest displayed sample at each present.
+ *
+ * Sample blocks are stamped in the audio callback; the render thread passes
+ * the newest stamp it drew together with the time display() returned. A
+ * summary is printed once per reporting interval.
+ */
+class LatencyMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param reportInterval Time between printed summaries.
+     * @param label Prefix of the printed summaries, e.g. to tell outputs apart.
+     */
+    explicit LatencyMonitor(Clock::duration reportInterval = std::chrono::seconds(1), std::string label = "Latency");
+
+    /**
+     * @brief Records one presented frame.
+     * @param newestSample Capture time of the newest sample in the frame.
+     * @param presentTime Time the frame was presented.
+     */
+    void recordPresent(Clock::time_point newestSample, Clock::time_point presentTime);
+
+private:
+    void report(Clock::time_point now);
+
+    Clock::duration m_reportInterval;
+    std::string m_label;
+    Clock::time_point m_lastReport;
+    std::vector<double> m_agesMs;
+    unsigned int m_framesWithoutAudio = 0;
+};
+
+#endif // LATENCY_HPP
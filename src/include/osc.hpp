@@ -9,6 +9,9 @@
 #include <mutex>
 #include <optional>
 
+#include "render_mode.hpp"
+#include "sweep_capture.hpp"
+
 #include "../libs/oscpack/osc/OscReceivedElements.h"
 #include "../libs/oscpack/osc/OscPacketListener.h"
 #include "../libs/oscpack/ip/UdpSocket.h"
@@ -28,6 +31,22 @@ public:
     std::optional<float> getPendingBlurSpread();
     std::optional<unsigned int> getPendingAlphaScale();
     std::optional<float> getPendingScale();
+    std::optional<RenderMode> getPendingRenderMode();
+    std::optional<float> getPendingDensityDecay();
+    std::optional<float> getPendingDensityGamma();
+    std::optional<float> getPendingTimeBase();
+    std::optional<unsigned int> getPendingTriggerSource();
+    std::optional<TriggerEdge> getPendingTriggerEdge();
+    std::optional<float> getPendingTriggerLevel();
+    std::optional<float> getPendingTriggerHysteresis();
+    std::optional<TriggerMode> getPendingTriggerMode();
+    std::optional<float> getPendingHoldoff();
+    std::optional<unsigned int> getPendingSweepCount();
+    std::optional<bool> getPendingQualityLock();
+    // Sender of the latest /quality query, to send the report back to
+    std::optional<IpEndpointName> getPendingQualityQuery();
+    // Sender of the latest /memory query
+    std::optional<IpEndpointName> getPendingMemoryQuery();
     int getIndex() const;
 
 protected:
@@ -44,6 +63,20 @@ private:
     std::optional<float> blur_spread_update_;
     std::optional<unsigned int> alpha_scale_update_;
     std::optional<float> scale_update_;
+    std::optional<RenderMode> render_mode_update_;
+    std::optional<float> density_decay_update_;
+    std::optional<float> density_gamma_update_;
+    std::optional<float> time_base_update_;
+    std::optional<unsigned int> trigger_source_update_;
+    std::optional<TriggerEdge> trigger_edge_update_;
+    std::optional<float> trigger_level_update_;
+    std::optional<float> trigger_hysteresis_update_;
+    std::optional<TriggerMode> trigger_mode_update_;
+    std::optional<float> holdoff_update_;
+    std::optional<unsigned int> sweep_count_update_;
+    std::optional<bool> quality_lock_update_;
+    std::optional<IpEndpointName> quality_query_from_;
+    std::optional<IpEndpointName> memory_query_from_;
 
     int rcv_index = 0;
 };
@@ -53,6 +86,10 @@ public:
     AsioOscReceiver(asio::io_context& io_context, OSCListener& listener);
     ~AsioOscReceiver();
     void stop();
+    // Called with every raw packet before it is parsed (e.g. to record it)
+    void setPacketObserver(std::function<void(const char*, std::size_t)> observer);
+    // Sends a packet from the listening port (e.g. a reply to a query); safe from any thread
+    void send(const IpEndpointName& destination, const char* data, std::size_t size);
 private:
     void startReceive();    
     void handleReceive(const asio::error_code& error, std::size_t bytes_recvd);
@@ -60,6 +97,7 @@ private:
     asio::ip::udp::endpoint remote_endpoint_asio_;
     std::array<char, MAX_OSC_BUFFER_SIZE_ASIO> recv_buffer_{};
     OSCListener& listener_;
+    std::function<void(const char*, std::size_t)> packet_observer_;
     bool stopped_ = false;
 };
 
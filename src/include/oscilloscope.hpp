@@ -5,12 +5,22 @@
 #include <SFML/Audio.hpp>
 #include <string>
 #include <vector>
-#include <mutex>
 #include <cstdint>
 #include <algorithm> // For std::min, std::max
+#include <array>
 #include <cmath>
-#include <deque>
+#include <cstddef>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "frame_ring.hpp"
+#include "render_mode.hpp"
+#include "render_output.hpp"
+#include "sample_format.hpp"
+#include "snapshot_exchange.hpp"
+#include "sweep_capture.hpp"
 
 
 sf::Vector2f normalize(const sf::Vector2f& source);
@@ -18,27 +28,103 @@ sf::Vector2f perpendicular(const sf::Vector2f& source);
 float distance(float x1, float y1, float x2, float y2);
 float distance(const sf::Vector2f& p1, const sf::Vector2f& p2);
 
+/**
+ * @struct ScopeGeometry
+ * @brief One complete, drawable snapshot of a scope's trace.
+ */
+struct ScopeGeometry {
+    std::vector<sf::Vertex> strip;
+    std::chrono::steady_clock::time_point newestSample{};
+};
+
 /**
  * @class Oscilloscope
  * @brief Captures and visualizes stereo audio data in real-time.
+ *
+ * The audio thread builds one geometry snapshot per block; every render
+ * output reads it independently, under its own output index.
  */
-class Oscilloscope : public sf::Drawable {
+class Oscilloscope {
 public:
-    // Constructor (default is sufficient here)
-    Oscilloscope(); 
+    // Upper limit of the persistence, whatever the memory quota
+    static constexpr unsigned int kMaxPersistenceSamples = 1u << 24;
+
+    Oscilloscope();
+    ~Oscilloscope();
 
     /**
      * @brief Updates the view parameters based on the new window/target size.
+     * Geometry is built in this target's pixels; other outputs map it with a view.
      * @param newSize The new size of the render target.
      */
     void updateView(const sf::Vector2u& newSize);
 
     /**
-     * @brief Processes a new chunk of audio samples.
-     * @param samples Pointer to the array of audio samples.
-     * @param sampleCount Number of samples in the array.
+     * @brief Center of the trace in geometry coordinates.
+     */
+    sf::Vector2f getViewCenter() const;
+
+    /**
+     * @brief Distance from the center to full scale in geometry coordinates.
+     */
+    float getViewRadius() const;
+
+    /**
+     * @brief Prepares per-output state (the density point ring) and reserves the
+     * output's density histogram in the memory quota. Call for every output that
+     * shows this scope, before audio starts.
+     * @param output Output index below kMaxOutputs.
+     */
+    void attachOutput(std::size_t output);
+
+    /**
+     * @brief Processes a new chunk of audio samples. Realtime-safe: never
+     * allocates, locks or blocks.
+     *
+     * Instantiated for Sample = std::int16_t, Int24, std::int32_t and float,
+     * with Stride = 2, 4, 8, 16 (fixed at compile time) or 0 (use frameStride).
+     * @param frames Pointer to the x sample of the first frame; y follows it.
+     * @param frameCount Number of frames in the block.
+     * @param frameStride Samples between consecutive frames (the interleaved channel count).
+     * @param captureTime Time the block reached the audio callback.
+     */
+    template <typename Sample, std::size_t Stride = 0>
+    void processSamples(const Sample* frames, std::size_t frameCount, std::size_t frameStride,
+                        std::chrono::steady_clock::time_point captureTime);
+
+    /**
+     * @brief Type-erased processSamples, so the instantiation can be picked once when the stream opens.
+     */
+    using IngestFn = void (Oscilloscope::*)(const void* frames, std::size_t frameCount, std::size_t frameStride,
+                                            std::chrono::steady_clock::time_point captureTime);
+
+    /**
+     * @brief Looks up the processSamples instantiation for a format and channel stride.
+     * @return Fixed-stride specialization when one exists, otherwise the runtime-stride one.
      */
-    void processSamples(const std::int16_t* samples, std::size_t sampleCount);
+    static IngestFn ingestFor(SampleFormat format, std::size_t frameStride);
+
+    /**
+     * @brief Frees history chunks the audio thread has given back, queues
+     * the next history resize and resizes idle geometry snapshots to the
+     * trace length. Call periodically from the control thread.
+     */
+    void releaseRetiredBuffers();
+
+    /**
+     * @brief Picks up the newest geometry published by the audio thread for one output.
+     * Must only be called from that output's render thread.
+     * @param output Output index below kMaxOutputs.
+     * @return True if a new snapshot was taken.
+     */
+    bool acquireGeometry(std::size_t output);
+
+    /**
+     * @brief Snapshot an output acquired last; read-only and shared with other outputs.
+     * @param output Output index that has called acquireGeometry().
+     * @return Geometry snapshot.
+     */
+    const ScopeGeometry& geometry(std::size_t output) const;
 
     /**
      * @brief Sets the trace thickness.
@@ -66,6 +152,8 @@ public:
 
     /**
      * @brief Sets the maximum number of frames for persistence effect.
+     * Limited to getMaxPersistenceSamples(). The history grows and shrinks
+     * by whole chunks, allocated and freed on the calling (control) thread.
      * @param n Number of frames.
      */
     void setPersistenceSamples(unsigned int n);
@@ -76,6 +164,46 @@ public:
      */
     unsigned int getPersistenceSamples() const;
 
+    /**
+     * @brief Sets the memory this scope may hold: trace history, geometry
+     * snapshots, and the density rings and histograms of attached outputs. The persistence is shortened at once if
+     * it no longer fits. Control thread.
+     * @param bytes Quota in bytes.
+     */
+    void setMemoryQuota(std::size_t bytes);
+
+    /**
+     * @brief Gets the memory quota.
+     * @return Quota in bytes.
+     */
+    std::size_t getMemoryQuota() const;
+
+    /**
+     * @brief Longest persistence that fits the memory quota.
+     * @return Number of persistence points.
+     */
+    unsigned int getMaxPersistenceSamples() const;
+
+    /**
+     * @brief Memory the scope holds now, including resizes in flight. Control thread.
+     * @return Bytes.
+     */
+    std::size_t getMemoryUsage() const;
+
+    /**
+     * @brief Memory the scope needs at a given persistence, with the outputs attached so far.
+     * @param samples Number of persistence points.
+     * @return Bytes.
+     */
+    std::size_t memoryFor(unsigned int samples) const;
+
+    /**
+     * @brief Memory reserved for density mode on the attached outputs: point rings and
+     * histograms at their capped size. Part of getMemoryUsage() and memoryFor().
+     * @return Bytes.
+     */
+    std::size_t getDensityMemory() const;
+
     /**
      * @brief Sets the strength of the oldest persistent points's visibility.
      * @param n Strength value (typically 0-255).
@@ -124,32 +252,331 @@ public:
      */
     unsigned int getAlphaScale() const;
 
+    /**
+     * @brief Switches between the trace strip and the density histogram.
+     * @param mode Render mode.
+     */
+    void setRenderMode(RenderMode mode);
+
+    /**
+     * @brief Gets the render mode.
+     * @return Render mode.
+     */
+    RenderMode getRenderMode() const;
+
+    /**
+     * @brief Sets how fast the density histogram fades.
+     * @param seconds Time constant of the exponential decay (s).
+     */
+    void setDensityDecay(float seconds);
+
+    /**
+     * @brief Gets the density decay time constant.
+     * @return Decay time constant (s).
+     */
+    float getDensityDecay() const;
+
+    /**
+     * @brief Sets the exponent applied to the log-compressed density.
+     * @param gamma Gamma value (below 1 brightens faint regions).
+     */
+    void setDensityGamma(float gamma);
+
+    /**
+     * @brief Gets the density gamma.
+     * @return Gamma value.
+     */
+    float getDensityGamma() const;
+
+    /**
+     * @brief Sets the input sample rate, which converts the Y-T times to frames.
+     * @param rate Frames per second.
+     */
+    void setSampleRate(unsigned int rate);
+
+    /**
+     * @brief Gets the input sample rate.
+     * @return Frames per second.
+     */
+    unsigned int getSampleRate() const;
+
+    /**
+     * @brief Sets the Y-T time base.
+     * @param seconds Duration of one sweep across the full width (s).
+     */
+    void setTimeBase(float seconds);
+
+    /**
+     * @brief Gets the Y-T time base.
+     * @return Sweep duration (s).
+     */
+    float getTimeBase() const;
+
+    /**
+     * @brief Sets the channel the Y-T trigger watches.
+     * @param channel 0 (x) or 1 (y).
+     */
+    void setTriggerSource(unsigned int channel);
+
+    /**
+     * @brief Gets the trigger source channel.
+     * @return 0 or 1.
+     */
+    unsigned int getTriggerSource() const;
+
+    /**
+     * @brief Sets the direction of the trigger crossing.
+     * @param edge Rising or falling.
+     */
+    void setTriggerEdge(TriggerEdge edge);
+
+    /**
+     * @brief Gets the trigger edge.
+     * @return Trigger edge.
+     */
+    TriggerEdge getTriggerEdge() const;
+
+    /**
+     * @brief Sets the trigger level.
+     * @param level Level in full-scale units (-1 to 1).
+     */
+    void setTriggerLevel(float level);
+
+    /**
+     * @brief Gets the trigger level.
+     * @return Level in full-scale units.
+     */
+    float getTriggerLevel() const;
+
+    /**
+     * @brief Sets how far past the level the source must go before the trigger arms.
+     * @param hysteresis Band width in full-scale units.
+     */
+    void setTriggerHysteresis(float hysteresis);
+
+    /**
+     * @brief Gets the trigger hysteresis.
+     * @return Band width in full-scale units.
+     */
+    float getTriggerHysteresis() const;
+
+    /**
+     * @brief Sets whether sweeps free-run without a trigger.
+     * @param mode Auto or normal.
+     */
+    void setTriggerMode(TriggerMode mode);
+
+    /**
+     * @brief Gets the trigger mode.
+     * @return Trigger mode.
+     */
+    TriggerMode getTriggerMode() const;
+
+    /**
+     * @brief Sets the time after a sweep during which triggers are ignored.
+     * @param seconds Holdoff (s).
+     */
+    void setHoldoff(float seconds);
+
+    /**
+     * @brief Gets the holdoff.
+     * @return Holdoff (s).
+     */
+    float getHoldoff() const;
+
+    /**
+     * @brief Sets how many of the latest sweeps are drawn, older ones fainter.
+     * @param n Sweep count, 1 to SweepCapture::kMaxSweeps.
+     */
+    void setSweepCount(unsigned int n);
+
+    /**
+     * @brief Gets the number of sweeps drawn.
+     * @return Sweep count.
+     */
+    unsigned int getSweepCount() const;
+
+    /**
+     * @brief Screen positions queued for an output's density histogram since it last consumed them.
+     * The audio thread only fills it in density mode. Must only be read from that output's render thread.
+     * @param output Output index passed to attachOutput().
+     * @return Ring of (x, y) frames.
+     */
+    FrameRing& densityPoints(std::size_t output);
+
+    /**
+     * @brief Requests that the trace strip be built from every n-th history point (quality governor).
+     * The strip is shared, so the largest stride any output requests wins.
+     * @param output Output index below kMaxOutputs.
+     * @param stride Point stride, 1 for every point.
+     */
+    void setPointStride(std::size_t output, unsigned int stride);
+
+    /**
+     * @brief Gets the trace point stride in effect.
+     * @return Point stride.
+     */
+    unsigned int getPointStride() const;
+
+    /**
+     * @brief Time the audio thread spent building trace geometry since this
+     * output's last call. Every output sees the full build time.
+     * Must only be called from that output's render thread.
+     * @param output Output index below kMaxOutputs.
+     * @return Accumulated build time.
+     */
+    std::chrono::nanoseconds takeGeometryBuildTime(std::size_t output);
+
 private:
+    template <typename Sample, std::size_t Stride>
+    void ingest(const void* frames, std::size_t frameCount, std::size_t frameStride,
+                std::chrono::steady_clock::time_point captureTime);
+
     /**
-     * @brief Called by SFML to draw the oscilloscope to a render target.
-     * @param target Render target to draw to.
-     * @param states Current render states.
+     * @brief Feeds a block to the Y-T trigger and sweep capture.
      */
-    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    template <typename Sample, std::size_t Stride>
+    void captureSweeps(const Sample* frames, std::size_t frameCount, std::size_t frameStride);
 
-    float m_radius = 0.f;
-    sf::Vector2f m_center;
-    mutable std::mutex m_mutex;
+    /**
+     * @brief Converts the Y-T parameters to frames at the current sample rate.
+     */
+    SweepCapture::Settings sweepSettings() const;
 
-    sf::Vertex prev_vertex;
-    sf::VertexArray m_triangle_strip;
-    std::deque<sf::Vertex> center_line_points;
-    std::deque<uint8_t> alpha_values;
+    /**
+     * @brief Fills a geometry slot with the latest sweeps, one strip per channel and sweep.
+     */
+    void buildSweepGeometry(ScopeGeometry& geometry);
+
+    /**
+     * @brief Applies a history resize queued by queueHistoryResize().
+     */
+    void adoptPendingHistory();
+
+    /**
+     * @brief Queues the chunks for the wanted history length, unless a
+     * resize is still in flight. Control thread.
+     */
+    void queueHistoryResize();
+
+    /**
+     * @brief Builds the triangle strip from the history and publishes it.
+     */
+    void publishGeometry(std::chrono::steady_clock::time_point captureTime);
+
+    /**
+     * @brief Fills the back geometry slot; publishGeometry() times and publishes it.
+     */
+    void buildGeometry(std::chrono::steady_clock::time_point captureTime);
+
+    /**
+     * @struct TraceHistory
+     * @brief Ring of past trace points, indexed newest first, stored in
+     * fixed-size chunks.
+     *
+     * The chunk table is allocated once at its largest size. grow() and
+     * shrink() only move chunk pointers and at most one chunk's points, so
+     * the audio thread can apply them; the chunks themselves are allocated
+     * and freed on the control thread.
+     */
+    struct TraceHistory {
+        struct Point {
+            sf::Vector2f position;
+            sf::Color color; // Trace color with the point's own (distance-based) alpha
+        };
+        using Chunk = std::unique_ptr<Point[]>;
+        static constexpr std::size_t kChunkPoints = 1024;
+        static constexpr std::size_t kMaxChunks = kMaxPersistenceSamples / kChunkPoints;
+
+        explicit TraceHistory(std::size_t chunks);
+        void push(const Point& point);
+        const Point& operator[](std::size_t i) const;
+        // Splices the chunks of added in as free space after the newest point
+        void grow(std::vector<Chunk>& added);
+        // Moves chunks holding the oldest points to removed (reserved by the caller) until `chunks` remain
+        void shrink(std::size_t chunks, std::vector<Chunk>& removed);
+        // Rotates the table so the newest point's chunk comes first
+        void rotateHeadToFront();
+
+        std::unique_ptr<Chunk[]> table;
+        std::size_t chunkCount;
+        std::size_t capacity;
+        std::size_t head = 0;
+        std::size_t count = 0;
+    };
+
+    /**
+     * @struct HistoryResize
+     * @brief A history resize, handed from the control thread to the audio thread and back.
+     */
+    struct HistoryResize {
+        std::size_t chunksBefore = 0;
+        std::size_t chunks = 0;
+        std::vector<TraceHistory::Chunk> spare; // Growing: the new chunks; shrinking: room for the removed ones
+    };
+
+    static std::size_t historyChunksFor(unsigned int samples);
+    void freeResize(HistoryResize* resize);
+
+    static constexpr unsigned int kDefaultPersistenceSamples = 10000;
+
+    // View, shared with the render thread
+    std::atomic<float> m_radius{0.f};
+    std::atomic<float> m_center_x{0.f};
+    std::atomic<float> m_center_y{0.f};
+
+    // Audio thread state
+    sf::Vector2f prev_position;
     bool m_has_valid_last_point;
+    TraceHistory m_history;
 
-    // Parameters
-    float scale = 1.f;
-    float m_thickness = 1.f;
-    unsigned int maxPersistentSamples = 10000;
+    // Y-T capture, audio thread only; m_lastMode detects switches into Y-T mode
+    SweepCapture m_sweeps;
+    RenderMode m_lastMode = RenderMode::Trace;
+    std::array<sf::Vector2f, 2 * SweepCapture::kColumns> m_sweepPoints{};
+
+    // History resizes: the control thread allocates chunks, the audio thread
+    // splices them in or out, and the control thread frees what came back
+    std::atomic<HistoryResize*> m_pendingResize{nullptr};
+    std::atomic<HistoryResize*> m_retiredResize{nullptr};
+
+    // Memory accounting, control thread only. m_historyChunks is the chunk
+    // count once the queued resize is applied; m_wantedChunks fits the persistence
+    std::size_t m_memoryQuota = SIZE_MAX;
+    std::size_t m_historyChunks;
+    std::size_t m_wantedChunks;
+    std::size_t m_allocatedChunks;
+    std::size_t m_geometryBytes = 0;
+
+    // Written by the audio thread, read lock-free by the render outputs
+    SnapshotExchange<ScopeGeometry, kMaxOutputs> m_geometry;
+    std::array<std::unique_ptr<FrameRing>, kMaxOutputs> m_densityPoints;
+
+    // Parameters, set from the control thread
+    std::atomic<float> scale{1.f};
+    std::atomic<float> m_thickness{1.f};
+    std::atomic<unsigned int> maxPersistentSamples{kDefaultPersistenceSamples};
     unsigned int persistenceStrength = 0;
-    float gaussianBlurSpread = 0.f;
-    sf::Color trace_color = sf::Color::Green;
-    unsigned int alpha_scale = 5000;
+    std::atomic<float> gaussianBlurSpread{0.f};
+    std::atomic<std::uint32_t> trace_color{sf::Color::Green.toInteger()};
+    std::atomic<unsigned int> alpha_scale{5000};
+    std::atomic<RenderMode> m_renderMode{RenderMode::Trace};
+    std::atomic<float> m_densityDecay{0.25f};
+    std::atomic<float> m_densityGamma{1.f};
+    std::array<std::atomic<unsigned int>, kMaxOutputs> m_pointStrides{};
+    std::atomic<unsigned int> m_sampleRate{48000};
+    std::atomic<float> m_timeBase{0.02f};
+    std::atomic<unsigned int> m_triggerSource{0};
+    std::atomic<TriggerEdge> m_triggerEdge{TriggerEdge::Rising};
+    std::atomic<float> m_triggerLevel{0.f};
+    std::atomic<float> m_triggerHysteresis{0.02f};
+    std::atomic<TriggerMode> m_triggerMode{TriggerMode::Auto};
+    std::atomic<float> m_holdoff{0.f};
+    std::atomic<unsigned int> m_sweepCount{1};
+
+    // Running total kept by the audio thread; each output remembers how much it has taken
+    std::atomic<std::int64_t> m_geometryBuildNs{0};
+    std::array<std::int64_t, kMaxOutputs> m_geometryBuildTakenNs{};
 };
 
 #endif // OSCILLOSCOPE_HPP
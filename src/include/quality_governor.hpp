@@ -0,0 +1,86 @@
+#ifndef QUALITY_GOVERNOR_HPP
+#define QUALITY_GOVERNOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @struct QualitySettings
+ * @brief What one quality level costs the renderer.
+ */
+struct QualitySettings {
+    unsigned int pointStride = 1;   ///< Build the trace strip from every n-th history point
+    unsigned int blurTaps = 4;      ///< Samples on each side of a blur pass; 0 skips the blur
+    float renderScale = 1.f;        ///< Offscreen resolution relative to the window
+};
+
+/**
+ * @class QualityGovernor
+ * @brief Lowers rendering quality while frames miss their target time, and restores it once they fit again.
+ *
+ * Level 0 is full quality. Each step up first decimates the trace points,
+ * then halves and finally drops the blur taps, then lowers the render scale.
+ * A step down needs sustained headroom. If a restored level overloads again
+ * soon after, the next restore waits twice as long, so the governor settles
+ * instead of oscillating between two levels.
+ *
+ * update() must only be called from the render thread; everything else is
+ * safe from any thread.
+ */
+class QualityGovernor {
+public:
+    static constexpr unsigned int kLevelCount = 6;
+
+    /**
+     * @brief Settings of a quality level, clamped to the valid range.
+     */
+    static const QualitySettings& settings(unsigned int level);
+
+    /**
+     * @param targetFrameMs Frame time the governor defends.
+     * @param locked Start locked at full quality.
+     */
+    explicit QualityGovernor(double targetFrameMs, bool locked = false);
+
+    /**
+     * @brief Feeds one frame's measurements.
+     * @param frameMs Time since the previous frame was presented.
+     * @param workMs Time spent producing the frame: rendering plus geometry builds.
+     * @return True if the level changed.
+     */
+    bool update(double frameMs, double workMs, std::chrono::steady_clock::time_point now);
+
+    unsigned int level() const { return m_level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Pins full quality (e.g. for recorded renders) or hands control back to the governor.
+     */
+    void setLocked(bool locked);
+    bool isLocked() const { return m_locked.load(std::memory_order_relaxed); }
+
+    double targetFrameMs() const { return m_targetFrameMs; }
+    double averageFrameMs() const { return m_frameMs.load(std::memory_order_relaxed); }
+    double averageWorkMs() const { return m_workMs.load(std::memory_order_relaxed); }
+
+private:
+    void changeLevel(unsigned int level, std::chrono::steady_clock::time_point now);
+
+    double m_targetFrameMs;
+    std::atomic<unsigned int> m_level{0};
+    std::atomic<bool> m_locked{false};
+    std::atomic<double> m_frameMs{0.0};
+    std::atomic<double> m_workMs{0.0};
+
+    // Render thread only
+    bool m_primed = false;
+    std::chrono::steady_clock::time_point m_lastChange{};
+    std::chrono::steady_clock::time_point m_overloadSince{};
+    std::chrono::steady_clock::time_point m_headroomSince{};
+    std::chrono::steady_clock::time_point m_lastRestore{};
+    bool m_overloaded = false;
+    bool m_headroom = false;
+    std::chrono::steady_clock::duration m_restoreHold;
+};
+
+#endif // QUALITY_GOVERNOR_HPP
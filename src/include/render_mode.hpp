@@ -0,0 +1,35 @@
+#ifndef RENDER_MODE_HPP
+#define RENDER_MODE_HPP
+
+#include <optional>
+#include <string_view>
+
+/**
+ * @enum RenderMode
+ * @brief How a scope turns its samples into pixels.
+ */
+enum class RenderMode {
+    Trace,      ///< Thick strip through the newest maxPersistentSamples points
+    Density,    ///< Per-pixel hit histogram with exponential decay ("digital phosphor")
+    TimeDomain  ///< Triggered Y-T sweeps of both channels
+};
+
+inline const char* renderModeName(RenderMode mode) {
+    switch (mode) {
+        case RenderMode::Trace: return "trace";
+        case RenderMode::Density: return "density";
+        case RenderMode::TimeDomain: return "yt";
+    }
+    return "unknown";
+}
+
+inline std::optional<RenderMode> parseRenderMode(std::string_view name) {
+    for (RenderMode mode : {RenderMode::Trace, RenderMode::Density, RenderMode::TimeDomain}) {
+        if (name == renderModeName(mode)) {
+            return mode;
+        }
+    }
+    return std::nullopt;
+}
+
+#endif // RENDER_MODE_HPP
@@ -0,0 +1,34 @@
+#ifndef RENDER_OUTPUT_HPP
+#define RENDER_OUTPUT_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Render outputs that can run at once; each reads the scopes' geometry independently.
+ */
+constexpr std::size_t kMaxOutputs = 4;
+
+/**
+ * @brief Where an output's frames go.
+ */
+enum class OutputKind {
+    Window,    ///< A window of its own, e.g. on a projector.
+    Offscreen  ///< A render texture, optionally exported to shared memory.
+};
+
+/**
+ * @struct OutputSpec
+ * @brief One render output and the scopes it shows (--output).
+ */
+struct OutputSpec {
+    OutputKind kind = OutputKind::Window;
+    unsigned int width = 800;
+    unsigned int height = 600;
+    unsigned int frameRate = 60;      // 0: as fast as frames can be rendered
+    std::vector<unsigned int> scopes; // Layered in this order; empty shows every scope
+    std::string shmName;              // Also publish frames to this shared-memory ring; empty disables
+};
+
+#endif // RENDER_OUTPUT_HPP
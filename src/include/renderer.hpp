@@ -0,0 +1,114 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "density_histogram.hpp"
+#include "oscilloscope.hpp"
+#include "frame_export.hpp"
+#include "quality_governor.hpp"
+#include "worker_pool.hpp"
+
+/**
+ * @class Renderer
+ * @brief Owns the offscreen passes (trace, blur, composite) for a set of scopes.
+ *
+ * One Renderer drives one output. It reads the scopes' geometry under its
+ * output index, so several renderers on different threads can draw the same
+ * scopes at once. Geometry is mapped onto the output with a view, keeping
+ * the trace centered and undistorted whatever the output's size.
+ *
+ * All methods must be called from the thread whose GL context is active on
+ * the final render target.
+ */
+class Renderer {
+public:
+    /**
+     * @param output Output index the scopes' geometry is read under, below kMaxOutputs.
+     * @param densityThreads Threads for density binning, counting the render thread; 0 picks the
+     *                       hardware concurrency. With several outputs each gets its share of the cores.
+     */
+    explicit Renderer(std::size_t output = 0, unsigned int densityThreads = 0);
+
+    /**
+     * @brief Loads the blur shader and allocates the offscreen textures.
+     * @param size Initial size of the render target.
+     * @return False if the shader could not be loaded.
+     */
+    bool init(const sf::Vector2u& size);
+
+    /**
+     * @brief Reallocates the offscreen textures for a new target size.
+     * @param size New size of the render target.
+     */
+    void resize(const sf::Vector2u& size);
+
+    /**
+     * @brief Additionally publishes every composited frame to shared memory.
+     * @param shmName POSIX shared memory name of the frame ring.
+     * @param slotCount Number of frames kept in the ring.
+     */
+    void enableExport(const std::string& shmName, unsigned int slotCount);
+
+    /**
+     * @brief Applies blur taps and render scale; reallocates the offscreen textures if the scale changed.
+     * @param quality Settings chosen by the quality governor (the point stride is applied by the scopes).
+     */
+    void setQuality(const QualitySettings& quality);
+
+    /**
+     * @brief Takes the newest geometry of every scope and draws it to the target.
+     * @param target Final render target (a window or a render texture).
+     * @param scopes Scopes to draw, layered in order.
+     * @return Capture time of the newest sample that was drawn.
+     */
+    std::chrono::steady_clock::time_point render(sf::RenderTarget& target, std::span<Oscilloscope* const> scopes);
+
+private:
+    /**
+     * @struct DensityLayer
+     * @brief Render-thread state of one scope in density mode.
+     */
+    struct DensityLayer {
+        DensityHistogram histogram;
+        sf::Texture texture;
+        std::chrono::steady_clock::time_point lastUpdate{};
+        bool active = false;
+    };
+
+    /**
+     * @brief Bins the scope's new samples and draws the histogram into traceTexture.
+     */
+    void drawDensity(Oscilloscope& scope, DensityLayer& layer);
+
+    /**
+     * @brief (Re)creates the offscreen textures for targetSize and the current render scale.
+     */
+    void allocateTextures();
+
+    /**
+     * @brief Region of the scope's geometry coordinates shown on this output.
+     */
+    sf::FloatRect sceneRect(const Oscilloscope& scope) const;
+
+    std::size_t output;
+    unsigned int densityThreads;
+    sf::Vector2u targetSize{0, 0};
+    sf::Vector2u scaledSize{0, 0};  // Size of the trace and blur passes
+    QualitySettings quality;
+    sf::RenderTexture traceTexture;
+    sf::RenderTexture compositeTexture;
+    sf::RenderTexture blurTexture;
+    sf::RenderTexture frameTexture;
+    sf::Shader gaussianBlurShader;
+    std::unique_ptr<FrameExporter> exporter;
+    std::vector<DensityLayer> densityLayers;
+    std::unique_ptr<WorkerPool> densityWorkers; // Created the first time a scope is in density mode
+};
+
+#endif // RENDERER_HPP
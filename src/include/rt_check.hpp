@@ -0,0 +1,68 @@
+#ifndef RT_CHECK_HPP
+#define RT_CHECK_HPP
+
+#include <cstdint>
+
+/**
+ * Debug checker for code that must stay realtime-safe (the audio callback).
+ *
+ * Built with OSCAR_RT_CHECK (`make RT_CHECK=1`), heap allocation, blocking
+ * mutex acquisition and stream output are intercepted process-wide; any such
+ * call made while a RealtimeSection is alive on the calling thread is
+ * recorded with its stack trace. Without OSCAR_RT_CHECK everything here
+ * compiles to nothing.
+ */
+namespace rtcheck {
+
+#ifdef OSCAR_RT_CHECK
+
+constexpr bool kEnabled = true;
+
+/**
+ * @class RealtimeSection
+ * @brief Marks the current thread as realtime for the lifetime of the object.
+ */
+class RealtimeSection {
+public:
+    RealtimeSection();
+    ~RealtimeSection();
+    RealtimeSection(const RealtimeSection&) = delete;
+    RealtimeSection& operator=(const RealtimeSection&) = delete;
+};
+
+/**
+ * @brief Resolves the interposed functions and warms up the unwinder, which
+ * allocates on first use. Call once from main() before any realtime thread starts.
+ */
+void init();
+
+/**
+ * @brief Total number of violations seen so far, across all threads.
+ */
+std::uint64_t violationCount();
+
+/**
+ * @brief Prints every distinct violating call site with its count and stack.
+ */
+void printSummary();
+
+#else
+
+constexpr bool kEnabled = false;
+
+class RealtimeSection {
+public:
+    RealtimeSection() {}
+    RealtimeSection(const RealtimeSection&) = delete;
+    RealtimeSection& operator=(const RealtimeSection&) = delete;
+};
+
+inline void init() {}
+inline std::uint64_t violationCount() { return 0; }
+inline void printSummary() {}
+
+#endif
+
+} // namespace rtcheck
+
+#endif // RT_CHECK_HPP
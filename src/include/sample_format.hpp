@@ -0,0 +1,79 @@
+#ifndef SAMPLE_FORMAT_HPP
+#define SAMPLE_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @brief Sample encodings the ingest path is specialized for. The values
+ * are stored in capture files and must not change.
+ */
+enum class SampleFormat : std::uint16_t {
+    Int16 = 1,
+    Int24 = 2,  ///< Packed 3-byte little-endian (RtAudio's RTAUDIO_SINT24)
+    Int32 = 3,
+    Float32 = 4
+};
+
+/**
+ * @struct Int24
+ * @brief One packed 24-bit sample.
+ */
+struct Int24 {
+    std::uint8_t bytes[3];
+};
+
+static_assert(sizeof(Int24) == 3, "Int24 must be packed");
+
+/**
+ * @brief Converts one sample to [-1, 1). Resolved entirely at compile time.
+ */
+template <typename Sample>
+inline float sampleToUnit(const Sample& s) {
+    if constexpr (std::is_same_v<Sample, std::int16_t>) {
+        return static_cast<float>(s) * (1.f / 32768.f);
+    } else if constexpr (std::is_same_v<Sample, Int24>) {
+        std::int32_t v = s.bytes[0] | (s.bytes[1] << 8) | (s.bytes[2] << 16);
+        v = (v ^ 0x800000) - 0x800000; // Sign-extend
+        return static_cast<float>(v) * (1.f / 8388608.f);
+    } else if constexpr (std::is_same_v<Sample, std::int32_t>) {
+        return static_cast<float>(s) * (1.f / 2147483648.f);
+    } else {
+        static_assert(std::is_same_v<Sample, float>, "Unsupported sample type");
+        return s;
+    }
+}
+
+inline std::size_t bytesPerSample(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16: return 2;
+        case SampleFormat::Int24: return 3;
+        case SampleFormat::Int32: return 4;
+        case SampleFormat::Float32: return 4;
+    }
+    return 0;
+}
+
+inline const char* sampleFormatName(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16: return "int16";
+        case SampleFormat::Int24: return "int24";
+        case SampleFormat::Int32: return "int32";
+        case SampleFormat::Float32: return "float32";
+    }
+    return "unknown";
+}
+
+inline std::optional<SampleFormat> parseSampleFormat(std::string_view name) {
+    for (SampleFormat format : {SampleFormat::Int16, SampleFormat::Int24, SampleFormat::Int32, SampleFormat::Float32}) {
+        if (name == sampleFormatName(format)) {
+            return format;
+        }
+    }
+    return std::nullopt;
+}
+
+#endif // SAMPLE_FORMAT_HPP
@@ -0,0 +1,172 @@
+#ifndef SHM_FRAME_HPP
+#define SHM_FRAME_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Layout of the POSIX shared-memory frame ring shared by the exporter and
+ * local consumers. The segment starts with a RingHeader, followed by
+ * slotCount slots of slotStride bytes each. A slot begins with a SlotHeader
+ * and is followed by the pixel data.
+ *
+ * Slots are written seqlock-style: the writer clears the slot's sequence,
+ * writes pixels, then stores the new sequence and finally latestSequence.
+ * A reader copies the slot and keeps the copy only if the slot's sequence
+ * still matches afterwards.
+ */
+namespace shmframe {
+
+constexpr std::uint32_t kMagic = 0x5246534f; // "OSFR"
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kHeaderAlign = 64;
+
+enum class PixelFormat : std::uint32_t {
+    RGBA8 = 1
+};
+
+// Rows are stored bottom-up (OpenGL readback order)
+constexpr std::uint32_t kFlagBottomUp = 0x1;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Frame ring needs address-free 64-bit atomics");
+
+struct alignas(kHeaderAlign) RingHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t slotCount;
+    std::uint32_t reserved;
+    std::uint64_t slotStride;    // Bytes per slot, header included
+    std::uint64_t maxFrameBytes; // Pixel capacity per slot
+    std::atomic<std::uint64_t> latestSequence; // 0 until the first frame
+    std::atomic<std::uint32_t> valid;          // Cleared when the writer abandons the segment
+};
+
+struct alignas(kHeaderAlign) SlotHeader {
+    std::atomic<std::uint64_t> sequence; // 0 while being written
+    std::uint64_t timestampNs;           // steady_clock time the frame was rendered
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t stride;                // Bytes per row
+    std::uint32_t size;                  // Bytes of pixel data
+    PixelFormat format;
+    std::uint32_t flags;
+};
+
+/**
+ * @brief Plain copy of a slot header, as returned to readers.
+ */
+struct FrameInfo {
+    std::uint64_t sequence = 0;
+    std::uint64_t timestampNs = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t stride = 0;
+    std::uint32_t size = 0;
+    PixelFormat format = PixelFormat::RGBA8;
+    std::uint32_t flags = 0;
+};
+
+/**
+ * @brief Current steady_clock time in nanoseconds, as used for frame timestamps.
+ */
+std::uint64_t nowNs();
+
+/**
+ * @class FrameRingWriter
+ * @brief Creates and publishes into a shared-memory frame ring.
+ */
+class FrameRingWriter {
+public:
+    FrameRingWriter() = default;
+    ~FrameRingWriter();
+    FrameRingWriter(const FrameRingWriter&) = delete;
+    FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+    /**
+     * @brief Creates (or replaces) the named segment.
+     * @param name POSIX shm name, e.g. "/oscar".
+     * @param slotCount Number of frame slots in the ring.
+     * @param maxFrameBytes Pixel capacity of each slot.
+     * @return False if the segment could not be created.
+     */
+    bool create(const std::string& name, std::uint32_t slotCount, std::size_t maxFrameBytes);
+
+    /**
+     * @brief Marks the segment invalid for readers and unlinks it.
+     */
+    void close();
+
+    bool isOpen() const { return m_base != nullptr; }
+    std::size_t maxFrameBytes() const { return m_maxFrameBytes; }
+
+    /**
+     * @brief Claims the next slot for writing.
+     * @return Pointer to the slot's pixel area (maxFrameBytes long).
+     */
+    std::uint8_t* beginFrame();
+
+    /**
+     * @brief Publishes the slot claimed by beginFrame().
+     */
+    void commitFrame(std::uint64_t timestampNs, std::uint32_t width, std::uint32_t height,
+                     std::uint32_t stride, PixelFormat format, std::uint32_t flags);
+
+private:
+    SlotHeader* slot(std::uint64_t sequence) const;
+
+    std::string m_name;
+    std::uint8_t* m_base = nullptr;
+    std::size_t m_mappedBytes = 0;
+    std::size_t m_maxFrameBytes = 0;
+    std::uint64_t m_sequence = 0;
+};
+
+/**
+ * @class FrameRingReader
+ * @brief Maps an existing frame ring read-only and copies out frames.
+ */
+class FrameRingReader {
+public:
+    FrameRingReader() = default;
+    ~FrameRingReader();
+    FrameRingReader(const FrameRingReader&) = delete;
+    FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+    /**
+     * @brief Maps the named segment.
+     * @return False if it does not exist or has an unexpected layout.
+     */
+    bool open(const std::string& name);
+    void close();
+
+    /**
+     * @brief Whether the writer still publishes into the mapped segment.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Sequence number of the newest published frame (0 if none).
+     */
+    std::uint64_t latestSequence() const;
+
+    /**
+     * @brief Copies the newest frame if it is newer than lastSequence.
+     * @param lastSequence Sequence of the frame the caller already has.
+     * @param info Receives the frame's header fields.
+     * @param pixels Destination of at least maxFrameBytes().
+     * @return True if a consistent new frame was copied.
+     */
+    bool readLatest(std::uint64_t lastSequence, FrameInfo& info, std::uint8_t* pixels) const;
+
+    std::size_t maxFrameBytes() const;
+
+private:
+    const std::uint8_t* m_base = nullptr;
+    std::size_t m_mappedBytes = 0;
+};
+
+} // namespace shmframe
+
+#endif // SHM_FRAME_HPP
@@ -0,0 +1,156 @@
+#ifndef SNAPSHOT_EXCHANGE_HPP
+#define SNAPSHOT_EXCHANGE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SnapshotExchange
+ * @brief Lock-free single-producer/multi-reader snapshot handoff.
+ *
+ * The producer fills back() and calls publish(); each reader calls
+ * acquire(reader) and then reads front(reader), which stays valid and
+ * unchanged until its next acquire(). No one ever waits: readers share the
+ * newest snapshot read-only, and the producer writes into a slot that no
+ * reader holds. With MaxReaders + 3 slots (one per reader, the newest, the
+ * producer's and one being grown) a free slot always exists.
+ *
+ * Each slot has a use word: the number of readers holding it, plus flag
+ * bits for the producer, for "newest" and for forEachIdleSlot(). A slot is
+ * free only while its word is zero, and every claim is a compare-exchange
+ * from zero.
+ */
+template <typename T, std::size_t MaxReaders>
+class SnapshotExchange {
+public:
+    SnapshotExchange() {
+        uses_[0] = kNewest;
+        uses_[1] = kProducer;
+        for (ReaderState& reader : readers_) {
+            reader.slot = kNoSlot;
+        }
+    }
+    SnapshotExchange(const SnapshotExchange&) = delete;
+    SnapshotExchange& operator=(const SnapshotExchange&) = delete;
+
+    /**
+     * @brief Number of snapshots the exchange holds, e.g. to account for their memory.
+     */
+    static constexpr std::size_t slotCount() { return kSlots; }
+
+    /**
+     * @brief Slot currently owned by the producer.
+     * @return Writable snapshot.
+     */
+    T& back() { return slots_[back_]; }
+
+    /**
+     * @brief Makes the producer's slot the newest snapshot and takes a free one.
+     * @return False if no slot was free (only possible while readers are
+     * mid-acquire); the snapshot is then dropped and back() is reused.
+     */
+    bool publish() {
+        std::size_t next = kNoSlot;
+        for (std::size_t i = 0; i < kSlots && next == kNoSlot; ++i) {
+            std::uint32_t expected = 0;
+            if (uses_[i].compare_exchange_strong(expected, kProducer)) {
+                next = i;
+            }
+        }
+        if (next == kNoSlot) {
+            return false;
+        }
+        // Mark the new newest slot before unmarking the old one, so neither is ever free while readable
+        uses_[back_].fetch_add(kNewest - kProducer);
+        const std::size_t previous = newest_.exchange(back_);
+        uses_[previous].fetch_sub(kNewest);
+        back_ = next;
+        return true;
+    }
+
+    /**
+     * @brief Takes the newest published snapshot for a reader, if it has a newer one.
+     * @param reader Index below MaxReaders; each index must only be used by one thread.
+     * @return True if front(reader) changed.
+     */
+    bool acquire(std::size_t reader) {
+        ReaderState& state = readers_[reader];
+        if (newest_.load() == state.slot) {
+            return false;
+        }
+        if (state.slot != kNoSlot) {
+            uses_[state.slot].fetch_sub(1);
+        }
+        // Pin the newest slot, then check it still is the newest: if so, the
+        // producer cannot have claimed it in between
+        std::size_t slot = newest_.load();
+        while (true) {
+            uses_[slot].fetch_add(1);
+            const std::size_t check = newest_.load();
+            if (check == slot) {
+                break;
+            }
+            uses_[slot].fetch_sub(1);
+            slot = check;
+        }
+        state.slot = slot;
+        return true;
+    }
+
+    /**
+     * @brief Snapshot a reader currently holds. Call acquire(reader) at least once first.
+     * @return Latest acquired snapshot.
+     */
+    const T& front(std::size_t reader) const { return slots_[readers_[reader].slot]; }
+
+    /**
+     * @brief Applies f to every slot. Only valid before the exchange is shared
+     * between threads (e.g. to preallocate storage).
+     */
+    template <typename F>
+    void forEachSlot(F&& f) {
+        for (T& slot : slots_) {
+            f(slot);
+        }
+    }
+
+    /**
+     * @brief Applies f to each slot nobody is using at the moment, while
+     * keeping everyone else off it (e.g. to grow storage outside the producer
+     * thread). May be called from one thread at a time, concurrently with
+     * the producer and the readers.
+     */
+    template <typename F>
+    void forEachIdleSlot(F&& f) {
+        for (std::size_t i = 0; i < kSlots; ++i) {
+            std::uint32_t expected = 0;
+            if (uses_[i].compare_exchange_strong(expected, kIdleClaim)) {
+                f(slots_[i]);
+                uses_[i].fetch_sub(kIdleClaim);
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t kSlots = MaxReaders + 3;
+    static constexpr std::size_t kNoSlot = kSlots;
+    // Low bits count readers holding the slot
+    static constexpr std::uint32_t kProducer = 1u << 16;
+    static constexpr std::uint32_t kNewest = 1u << 17;
+    static constexpr std::uint32_t kIdleClaim = 1u << 18;
+
+    // Written only by its reader; padded so readers do not share a cache line
+    struct alignas(64) ReaderState {
+        std::size_t slot;
+    };
+
+    std::array<T, kSlots> slots_{};
+    std::array<std::atomic<std::uint32_t>, kSlots> uses_{};
+    std::atomic<std::size_t> newest_{0};
+    std::size_t back_ = 1;
+    std::array<ReaderState, MaxReaders> readers_{};
+};
+
+#endif // SNAPSHOT_EXCHANGE_HPP
@@ -0,0 +1,144 @@
+#ifndef STREAM_AGGREGATOR_HPP
+#define STREAM_AGGREGATOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "frame_ring.hpp"
+#include "sample_format.hpp"
+
+/**
+ * @class DriftEstimator
+ * @brief Estimates the rate ratio between two clocks from a buffer's fill level.
+ *
+ * PI control of the (smoothed) level around a target: the integral term
+ * converges to the relative clock skew, the proportional term pulls the
+ * level back after a disturbance. Same loop as the UDP jitter buffer's.
+ */
+class DriftEstimator {
+public:
+    /**
+     * @param nominalRatio Producer frames per consumer frame at the nominal sample rates.
+     */
+    explicit DriftEstimator(double nominalRatio = 1.0);
+
+    /**
+     * @brief Restarts the estimate, e.g. after an underrun.
+     */
+    void reset(double levelFrames);
+
+    /**
+     * @brief Feeds one level measurement.
+     * @param levelFrames Buffered producer frames ahead of the read position.
+     * @param targetFrames Level the loop steers towards.
+     * @param producerRate Nominal producer sample rate.
+     * @param dtSeconds Time since the previous update.
+     * @return Producer frames to consume per consumer frame.
+     */
+    double update(double levelFrames, double targetFrames, double producerRate, double dtSeconds);
+
+    double ratio() const { return m_nominalRatio * m_correction; }
+
+    /**
+     * @brief Smoothed level the loop is currently acting on.
+     */
+    double levelFrames() const { return m_levelAverage; }
+
+    /**
+     * @brief Estimated skew of the producer clock relative to the consumer clock.
+     */
+    double driftPpm() const { return m_integral * 1e6; }
+
+private:
+    double m_nominalRatio;
+    double m_levelAverage = 0.0;
+    double m_integral = 0.0;
+    double m_correction = 1.0;
+};
+
+/**
+ * @class StreamAggregator
+ * @brief Merges several independently clocked input streams into one interleaved block.
+ *
+ * Stream 0 is the master: its callback drives the output, and everything is
+ * resampled onto its clock. Every other stream's callback converts its block
+ * to float and pushes it into that stream's FrameRing. When the master
+ * callback runs, each ring is drained through a linear-interpolating
+ * resampler whose ratio comes from the ring's DriftEstimator. This keeps
+ * every ring near its target level, so streams stay aligned and no buffer
+ * grows, whatever the clocks do.
+ *
+ * Each input stream carries channel pairs; pair k of a stream is written to
+ * output pair outputPairs[k]. Output pairs no stream maps stay silent.
+ *
+ * Streams must all be added before any of them starts. streamInput() is
+ * realtime-safe: it never allocates, locks or blocks.
+ */
+class StreamAggregator {
+public:
+    using Sink = std::function<void(const float* frames, unsigned int nFrames, unsigned int nChannels, double streamTime)>;
+
+    struct StreamStats {
+        double ratio = 1.0;             ///< Input frames consumed per master frame
+        double driftPpm = 0.0;          ///< Estimated clock skew against the master
+        double levelMs = 0.0;           ///< Buffered audio ahead of the read position
+        double targetMs = 0.0;
+        std::uint64_t underruns = 0;    ///< Times the ring ran dry and silence was inserted
+        std::uint64_t overflows = 0;    ///< Frames dropped because the ring was full
+    };
+
+    /**
+     * @param outputChannels Channels of the aggregate block handed to the sink.
+     * @param marginMs Extra buffering on top of one block of each side, against callback jitter.
+     */
+    StreamAggregator(unsigned int outputChannels, double marginMs, Sink sink);
+    ~StreamAggregator();
+    StreamAggregator(const StreamAggregator&) = delete;
+    StreamAggregator& operator=(const StreamAggregator&) = delete;
+
+    /**
+     * @brief Registers a stream. The first one added is the master clock.
+     * @param outputPairs Output channel pair for each channel pair of the stream.
+     * @param sampleRate Nominal sample rate of the stream.
+     * @param blockFrames Frames per callback of the stream.
+     * @return Index to pass to streamInput().
+     */
+    std::size_t addStream(const std::vector<unsigned int>& outputPairs, unsigned int sampleRate,
+                          unsigned int blockFrames);
+
+    /**
+     * @brief Hands one block from a stream's audio callback to the aggregator.
+     * For the master, this also produces and delivers an aggregate block.
+     * @param frameStride Samples between consecutive frames of the input block.
+     * @param arrival Time the callback ran. Used to interpolate ring levels
+     * between a slave's callbacks, so block-sized steps do not read as drift.
+     */
+    void streamInput(std::size_t stream, const void* samples, SampleFormat format, unsigned int nFrames,
+                     std::size_t frameStride, double streamTime, std::chrono::steady_clock::time_point arrival);
+
+    std::size_t streamCount() const { return m_streams.size(); }
+
+    /**
+     * @brief Latest statistics of a stream, safe to call from any thread.
+     */
+    StreamStats stats(std::size_t stream) const;
+
+private:
+    struct Stream;
+
+    void pullResampled(Stream& stream, float* out, unsigned int nFrames, std::chrono::steady_clock::time_point now);
+
+    unsigned int m_outputChannels;
+    double m_marginMs;
+    Sink m_sink;
+    std::vector<std::unique_ptr<Stream>> m_streams;
+    std::vector<float> m_block;
+    unsigned int m_blockCapacity = 0;
+};
+
+#endif // STREAM_AGGREGATOR_HPP
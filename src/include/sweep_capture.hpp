@@ -0,0 +1,182 @@
+#ifndef SWEEP_CAPTURE_HPP
+#define SWEEP_CAPTURE_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+/**
+ * @enum TriggerEdge
+ * @brief Direction in which the trigger source has to cross the level.
+ */
+enum class TriggerEdge {
+    Rising,
+    Falling
+};
+
+inline const char* triggerEdgeName(TriggerEdge edge) {
+    switch (edge) {
+        case TriggerEdge::Rising: return "rising";
+        case TriggerEdge::Falling: return "falling";
+    }
+    return "unknown";
+}
+
+inline std::optional<TriggerEdge> parseTriggerEdge(std::string_view name) {
+    for (TriggerEdge edge : {TriggerEdge::Rising, TriggerEdge::Falling}) {
+        if (name == triggerEdgeName(edge)) {
+            return edge;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @enum TriggerMode
+ * @brief What the capture does while no trigger arrives.
+ */
+enum class TriggerMode {
+    Auto,   ///< Free-runs a sweep after a while without a trigger, so quiet signals stay visible
+    Normal  ///< Sweeps only on a trigger; the last sweeps stay on screen
+};
+
+inline const char* triggerModeName(TriggerMode mode) {
+    switch (mode) {
+        case TriggerMode::Auto: return "auto";
+        case TriggerMode::Normal: return "normal";
+    }
+    return "unknown";
+}
+
+inline std::optional<TriggerMode> parseTriggerMode(std::string_view name) {
+    for (TriggerMode mode : {TriggerMode::Auto, TriggerMode::Normal}) {
+        if (name == triggerModeName(mode)) {
+            return mode;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @class SweepCapture
+ * @brief Triggered time-base capture of a channel pair, for the Y-T view.
+ *
+ * Runs on the audio thread, one chunk of at most kChunkFrames frames at a
+ * time. The trigger arms once the source has been beyond the hysteresis band
+ * below the level (above it, for falling edges) and fires when the source
+ * then crosses the level. A sweep records sweepFrames frames from the
+ * trigger sample on, then holdoffFrames are skipped before the trigger arms
+ * again. Sweeps are kept as min/max columns in a ring allocated by the
+ * constructor, so nothing here allocates afterwards.
+ */
+class SweepCapture {
+public:
+    static constexpr std::size_t kChunkFrames = 256;
+    static constexpr std::size_t kMaxSweepFrames = 1 << 16;
+    static constexpr std::size_t kColumns = 512;
+    // Completed sweeps kept for display; one more slot is being recorded
+    static constexpr std::size_t kMaxSweeps = 4;
+
+    /**
+     * @struct Settings
+     * @brief Trigger and time base, in frames and full-scale units.
+     */
+    struct Settings {
+        unsigned int source = 0;        ///< Channel that triggers, 0 or 1
+        TriggerEdge edge = TriggerEdge::Rising;
+        TriggerMode mode = TriggerMode::Auto;
+        float level = 0.f;
+        float hysteresis = 0.02f;       ///< How far past the level the source must go to arm
+        std::size_t sweepFrames = 960;  ///< Frames per sweep, at most kMaxSweepFrames
+        std::size_t holdoffFrames = 0;  ///< Frames skipped after a sweep before arming
+        std::size_t autoFrames = 4800;  ///< Frames without a trigger before Auto mode free-runs
+    };
+
+    /**
+     * @struct Column
+     * @brief Range of one channel over one screen column of a sweep.
+     */
+    struct Column {
+        float low;
+        float high;
+        float first; ///< First sample, so the range can be drawn in time order
+        float last;
+    };
+
+    /**
+     * @struct Sweep
+     * @brief One recorded sweep of both channels.
+     */
+    struct Sweep {
+        std::array<std::array<Column, kColumns>, 2> columns;
+        std::size_t columnCount = 0;
+        bool triggered = false; ///< False for sweeps free-run in Auto mode
+    };
+
+    SweepCapture();
+
+    /**
+     * @brief Buffer the caller fills with one channel of the next chunk.
+     * @param channel 0 or 1.
+     * @return kChunkFrames samples in full-scale units.
+     */
+    float* input(unsigned int channel) { return m_input[channel].data(); }
+
+    /**
+     * @brief Runs trigger and capture over the first frames of input().
+     * @param frames At most kChunkFrames.
+     * @param settings Trigger and time base; may change between chunks.
+     */
+    void process(std::size_t frames, const Settings& settings);
+
+    /**
+     * @brief Drops all sweeps and waits for a new trigger.
+     */
+    void reset();
+
+    /**
+     * @brief Completed sweeps available, at most kMaxSweeps.
+     */
+    std::size_t sweepCount() const;
+
+    /**
+     * @brief Completed sweep by age.
+     * @param age 0 for the newest, below sweepCount().
+     */
+    const Sweep& sweep(std::size_t age) const;
+
+private:
+    enum class State {
+        Holdoff,
+        Arming,
+        Armed,
+        Capturing
+    };
+
+    void startSweep(bool triggered, const Settings& settings);
+
+    /**
+     * @brief Records input frames [offset, offset + frames) into the current sweep.
+     * @return Frames consumed; fewer than frames if the sweep completed.
+     */
+    std::size_t capture(std::size_t offset, std::size_t frames, const Settings& settings);
+
+    static constexpr std::size_t kSlots = kMaxSweeps + 1;
+
+    std::array<std::array<float, kChunkFrames>, 2> m_input{};
+    std::array<float, kChunkFrames> m_trigger{};
+    std::unique_ptr<Sweep[]> m_ring;
+    std::size_t m_writeSlot = 0;
+    std::size_t m_completed = 0;
+
+    State m_state = State::Arming;
+    std::size_t m_holdoffLeft = 0;
+    std::size_t m_waited = 0;      // Frames searched for a trigger since arming began
+    std::size_t m_sweepFrames = 0; // Length of the sweep being recorded
+    std::size_t m_captured = 0;
+    std::size_t m_column = 0;
+};
+
+#endif // SWEEP_CAPTURE_HPP
@@ -0,0 +1,142 @@
+#ifndef UDP_AUDIO_HPP
+#define UDP_AUDIO_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "asio.hpp"
+
+#include "jitter_buffer.hpp"
+
+/**
+ * Wire format of the UDP audio stream: one datagram per packet, a
+ * PacketHeader followed by frames * channels interleaved int16 samples, all
+ * little-endian. Every packet of a stream carries the same number of frames;
+ * the sequence number increments by one per packet. A receiver drops
+ * packets with more channels than it plays out, more than kMaxPacketFrames
+ * frames, or a sample rate outside kMinSampleRate to kMaxSampleRate.
+ * senderTimeNs is the
+ * sender's steady clock at the first frame, which lets a receiver on the
+ * same host measure end-to-end latency.
+ */
+namespace udpaudio {
+
+constexpr std::uint32_t kMagic = 0x5543534F; // "OSCU"
+constexpr std::uint16_t kVersion = 1;
+constexpr unsigned short kDefaultPort = 7001;
+constexpr std::size_t kMaxPacketBytes = 65507;
+// Packets outside these limits are dropped as malformed
+constexpr std::uint32_t kMinSampleRate = 8000;
+constexpr std::uint32_t kMaxSampleRate = 192000;
+constexpr std::uint32_t kMaxPacketFrames = 4096;
+
+struct PacketHeader {
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint16_t channels;
+    std::uint32_t sequence;
+    std::uint32_t frames;
+    std::uint32_t sampleRate;
+    std::uint32_t reserved;
+    std::uint64_t senderTimeNs;
+};
+
+static_assert(sizeof(PacketHeader) == 32, "UDP audio header is 32 bytes");
+
+/**
+ * @brief Steady-clock time in nanoseconds, the clock used for packet timestamps.
+ */
+std::uint64_t nowNs();
+
+/**
+ * @class UdpAudioReceiver
+ * @brief Receives the UDP audio stream and plays it out through a jitter buffer.
+ *
+ * Reception and playout share one asio thread, so the jitter buffer needs no
+ * locking. Every blockFrames output frames (on the local clock) the sink is
+ * called with interleaved int16 samples, just like an RtAudio input callback.
+ */
+class UdpAudioReceiver {
+public:
+    using Sink = std::function<void(const std::int16_t* samples, unsigned int nFrames,
+                                    unsigned int nChannels, double streamTime)>;
+
+    /**
+     * @param port UDP port to listen on.
+     * @param channels Channels handed to the sink.
+     * @param blockFrames Frames per sink call.
+     * @param minDelayMs Lower bound of the jitter buffer's target delay.
+     * @param maxDelayMs Upper bound of the jitter buffer's target delay.
+     */
+    UdpAudioReceiver(unsigned short port, unsigned int channels, unsigned int blockFrames,
+                     double minDelayMs, double maxDelayMs, Sink sink);
+    ~UdpAudioReceiver();
+    UdpAudioReceiver(const UdpAudioReceiver&) = delete;
+    UdpAudioReceiver& operator=(const UdpAudioReceiver&) = delete;
+
+    /**
+     * @brief Binds the port and starts the receive/playout thread.
+     * @return False if the socket could not be opened.
+     */
+    bool start();
+
+    /**
+     * @brief Stops the thread and prints a summary.
+     */
+    void stop();
+
+    /**
+     * @brief Prints jitter buffer and latency statistics once per second while running.
+     */
+    void setReportStats(bool report) { m_reportStats = report; }
+
+    /**
+     * @brief Sample rate of the blocks handed to the sink, or 0 before the stream has locked on.
+     * May be polled from any thread; it changes when the sender deliberately switches format.
+     */
+    unsigned int sampleRate() const { return m_sampleRate.load(std::memory_order_relaxed); }
+
+private:
+    void startReceive();
+    void handleReceive(const asio::error_code& error, std::size_t bytes);
+    void schedulePlayout();
+    void playout();
+    void report(bool final);
+
+    unsigned short m_port;
+    unsigned int m_channels;
+    unsigned int m_blockFrames;
+    Sink m_sink;
+
+    asio::io_context m_io;
+    asio::ip::udp::socket m_socket;
+    asio::ip::udp::endpoint m_remote;
+    asio::steady_timer m_timer;
+    alignas(8) std::array<char, kMaxPacketBytes> m_packet{};
+    std::vector<std::int16_t> m_block;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<unsigned int> m_sampleRate{0};
+    bool m_reportStats = false;
+
+    JitterBuffer m_jitter;
+    std::chrono::steady_clock::time_point m_nextPlayout;
+    std::chrono::steady_clock::time_point m_lastReport;
+    std::uint64_t m_blocksPlayed = 0;
+    std::uint64_t m_malformed = 0;
+
+    // End-to-end latency of played blocks (sender clock to sink call), per report
+    std::vector<double> m_latenciesMs;
+    std::uint64_t m_totalPackets = 0;
+    std::uint64_t m_totalLost = 0;
+    std::uint64_t m_totalConcealed = 0;
+};
+
+} // namespace udpaudio
+
+#endif // UDP_AUDIO_HPP
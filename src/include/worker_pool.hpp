@@ -0,0 +1,58 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkerPool
+ * @brief Fixed set of threads for fork/join loops on the render thread.
+ *
+ * parallelFor() hands out task indices to the workers and to the calling
+ * thread, and returns once every task has run. Not realtime-safe: it locks
+ * and waits, so it must never be used from the audio callback.
+ */
+class WorkerPool {
+public:
+    /**
+     * @param threads Total threads including the caller; 0 picks the hardware concurrency.
+     */
+    explicit WorkerPool(unsigned int threads = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Threads that run tasks, counting the caller of parallelFor().
+     */
+    unsigned int size() const { return static_cast<unsigned int>(m_threads.size()) + 1; }
+
+    /**
+     * @brief Runs task(i) for every i in [0, count) and waits for all of them.
+     * Must not be called from within a task.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+private:
+    void workerLoop();
+    void runTasks();
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::uint64_t m_generation = 0;
+    unsigned int m_busy = 0;
+    bool m_stopping = false;
+
+    const std::function<void(std::size_t)>* m_task = nullptr;
+    std::size_t m_count = 0;
+    std::atomic<std::size_t> m_next{0};
+};
+
+#endif // WORKER_POOL_HPP
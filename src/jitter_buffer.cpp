@@ -0,0 +1,281 @@
+#include "include/jitter_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Target delay in multiples of the interarrival jitter
+constexpr double kJitterMultiple = 4.0;
+// Drift controller: proportional and integral gains on the level error (s)
+constexpr double kRateKp = 0.2;
+constexpr double kRateKi = 0.02;
+constexpr double kMaxRateDeviation = 0.005;
+constexpr double kLevelSmoothing = 0.05;
+// Concealment fades the repeated packet to silence over this many packets
+constexpr double kConcealPackets = 3.0;
+// A new format must be all that arrives for this long before the stream re-syncs to it
+constexpr std::uint64_t kFormatSwitchNs = 500'000'000;
+
+std::int16_t toSample(float v) {
+    return static_cast<std::int16_t>(std::lrint(std::clamp(v, -32768.f, 32767.f)));
+}
+
+} // namespace
+
+JitterBuffer::JitterBuffer(unsigned int outputChannels, double minDelayMs, double maxDelayMs)
+    : m_outputChannels(outputChannels), m_minDelayMs(minDelayMs), m_maxDelayMs(std::max(minDelayMs, maxDelayMs)),
+      m_frameA(outputChannels), m_frameB(outputChannels) {
+}
+
+void JitterBuffer::reset(unsigned int nFrames, unsigned int nChannels, unsigned int sampleRate) {
+    m_packetFrames = nFrames;
+    m_inputChannels = nChannels;
+    m_sampleRate = sampleRate;
+
+    // Room for twice the largest delay, plus history for concealment and late detection
+    const double maxDelayFrames = m_maxDelayMs * sampleRate / 1000.0;
+    const std::size_t slotCount = static_cast<std::size_t>(std::ceil(maxDelayFrames / nFrames)) * 2 + 8;
+    m_slots.assign(slotCount, Slot{});
+    m_samples.assign(slotCount * nFrames * nChannels, 0);
+
+    m_started = false;
+    m_buffering = true;
+    m_played = false;
+    m_lastGoodPacket = ~0ull;
+    m_lastCheckedPacket = ~0ull;
+    m_concealRun = 0;
+    m_haveTransit = false;
+    m_jitterNs = 0.0;
+    updateTarget();
+    m_levelAverage = m_targetFrames;
+    m_rateIntegral = 0.0;
+    m_rate = 1.0;
+}
+
+std::uint64_t JitterBuffer::extendSequence(std::uint32_t sequence) const {
+    if (!m_started) {
+        return sequence;
+    }
+    const auto delta = static_cast<std::int32_t>(sequence - static_cast<std::uint32_t>(m_highestPacket));
+    if (delta < 0 && static_cast<std::uint64_t>(-static_cast<std::int64_t>(delta)) > m_highestPacket) {
+        return 0;
+    }
+    return m_highestPacket + delta;
+}
+
+const JitterBuffer::Slot* JitterBuffer::find(std::uint64_t packet) const {
+    const Slot& slot = m_slots[packet % m_slots.size()];
+    return slot.packet == packet ? &slot : nullptr;
+}
+
+const std::int16_t* JitterBuffer::slotSamples(const Slot& slot) const {
+    const auto index = static_cast<std::size_t>(&slot - m_slots.data());
+    return m_samples.data() + index * m_packetFrames * m_inputChannels;
+}
+
+void JitterBuffer::push(std::uint32_t sequence, std::uint64_t senderTimeNs, const std::int16_t* samples,
+                        unsigned int nFrames, unsigned int nChannels, unsigned int sampleRate, std::uint64_t arrivalNs) {
+    if (nFrames == 0 || nChannels == 0 || sampleRate == 0) {
+        return;
+    }
+    if (m_packetFrames == 0) {
+        reset(nFrames, nChannels, sampleRate);
+    } else if (nFrames != m_packetFrames || nChannels != m_inputChannels || sampleRate != m_sampleRate) {
+        if (nFrames != m_nextPacketFrames || nChannels != m_nextChannels || sampleRate != m_nextSampleRate) {
+            m_nextPacketFrames = nFrames;
+            m_nextChannels = nChannels;
+            m_nextSampleRate = sampleRate;
+            m_nextFormatSinceNs = arrivalNs;
+        }
+        if (arrivalNs - m_nextFormatSinceNs < kFormatSwitchNs) {
+            ++m_counters.foreign;
+            return;
+        }
+        reset(nFrames, nChannels, sampleRate);
+    }
+    m_nextPacketFrames = 0;
+    ++m_counters.received;
+
+    // RFC 3550 interarrival jitter: smoothed change in one-way transit time
+    const double transitNs = static_cast<double>(arrivalNs) - static_cast<double>(senderTimeNs);
+    if (m_haveTransit) {
+        m_jitterNs += (std::abs(transitNs - m_lastTransitNs) - m_jitterNs) / 16.0;
+    }
+    m_lastTransitNs = transitNs;
+    m_haveTransit = true;
+    updateTarget();
+
+    const std::uint64_t packet = extendSequence(sequence);
+    if (!m_started) {
+        m_started = true;
+        m_highestPacket = packet;
+        m_readPos = static_cast<double>(packet * m_packetFrames);
+    } else if (packet > m_highestPacket + m_slots.size() ||
+               static_cast<double>((packet + m_slots.size()) * m_packetFrames) < m_readPos) {
+        // Far outside the window: the sender restarted or skipped ahead, so resynchronise
+        m_highestPacket = packet;
+        m_readPos = static_cast<double>(packet * m_packetFrames);
+        m_buffering = true;
+    }
+
+    if (static_cast<double>((packet + 1) * m_packetFrames) <= m_readPos) {
+        ++m_counters.late;
+        return;
+    }
+    Slot& slot = m_slots[packet % m_slots.size()];
+    if (slot.packet == packet) {
+        ++m_counters.duplicates;
+        return;
+    }
+    slot.packet = packet;
+    slot.senderTimeNs = senderTimeNs;
+    std::memcpy(m_samples.data() + (packet % m_slots.size()) * m_packetFrames * m_inputChannels, samples,
+                sizeof(std::int16_t) * m_packetFrames * m_inputChannels);
+    m_highestPacket = std::max(m_highestPacket, packet);
+}
+
+void JitterBuffer::updateTarget() {
+    // A whole packet and a whole output block must fit on top of the jitter margin
+    const double floorFrames = static_cast<double>(m_packetFrames + m_pullFrames);
+    const double minFrames = std::max(floorFrames, m_minDelayMs * m_sampleRate / 1000.0);
+    const double maxFrames = std::max(minFrames, m_maxDelayMs * m_sampleRate / 1000.0);
+    m_targetFrames = std::clamp(floorFrames + kJitterMultiple * m_jitterNs * m_sampleRate / 1e9, minFrames, maxFrames);
+}
+
+double JitterBuffer::levelFrames() const {
+    return static_cast<double>((m_highestPacket + 1) * m_packetFrames) - m_readPos;
+}
+
+bool JitterBuffer::fetchFrame(std::uint64_t frame, float* out) const {
+    const Slot* slot = find(frame / m_packetFrames);
+    if (!slot) {
+        return false;
+    }
+    const std::int16_t* src = slotSamples(*slot) + (frame % m_packetFrames) * m_inputChannels;
+    const unsigned int shared = std::min(m_inputChannels, m_outputChannels);
+    for (unsigned int c = 0; c < shared; ++c) {
+        out[c] = static_cast<float>(src[c]);
+    }
+    std::fill(out + shared, out + m_outputChannels, 0.f);
+    return true;
+}
+
+void JitterBuffer::conceal(float* out) {
+    // Repeat the last good packet, fading it out over a few packets
+    const double gain = std::max(0.0, 1.0 - static_cast<double>(m_concealRun) / (kConcealPackets * m_packetFrames));
+    const Slot* source = m_lastGoodPacket == ~0ull ? nullptr : find(m_lastGoodPacket);
+    if (!source || gain <= 0.0) {
+        std::fill(out, out + m_outputChannels, 0.f);
+    } else {
+        const std::uint64_t frame = m_lastGoodPacket * m_packetFrames + m_concealRun % m_packetFrames;
+        fetchFrame(frame, out);
+        for (unsigned int c = 0; c < m_outputChannels; ++c) {
+            out[c] *= static_cast<float>(gain);
+        }
+    }
+    ++m_concealRun;
+    ++m_counters.concealedFrames;
+}
+
+void JitterBuffer::updateRate(unsigned int nFrames) {
+    // PI control of the buffer level: play faster when too much is buffered
+    m_levelAverage += (levelFrames() - m_levelAverage) * kLevelSmoothing;
+    const double errorSeconds = (m_levelAverage - m_targetFrames) / m_sampleRate;
+    const double dt = static_cast<double>(nFrames) / m_sampleRate;
+    m_rateIntegral = std::clamp(m_rateIntegral + kRateKi * errorSeconds * dt, -kMaxRateDeviation, kMaxRateDeviation);
+    m_rate = 1.0 + std::clamp(kRateKp * errorSeconds + m_rateIntegral, -kMaxRateDeviation, kMaxRateDeviation);
+}
+
+bool JitterBuffer::pull(std::int16_t* out, unsigned int nFrames, std::uint64_t& senderTimeNs) {
+    senderTimeNs = 0;
+    if (!m_started) {
+        return false;
+    }
+    if (nFrames != m_pullFrames) {
+        m_pullFrames = nFrames;
+        updateTarget();
+    }
+
+    if (m_buffering && levelFrames() >= m_targetFrames) {
+        m_buffering = false;
+    }
+    if (m_buffering && !m_played) {
+        return false;
+    }
+    if (!m_buffering && levelFrames() > m_targetFrames + m_maxDelayMs * m_sampleRate / 1000.0) {
+        // Fell far behind (e.g. after a stall): drop the backlog instead of slowly draining it
+        m_readPos = static_cast<double>((m_highestPacket + 1) * m_packetFrames) - m_targetFrames;
+        m_levelAverage = m_targetFrames;
+    }
+    m_played = true;
+    updateRate(nFrames);
+
+    float* a = m_frameA.data();
+    float* b = m_frameB.data();
+    for (unsigned int f = 0; f < nFrames; ++f) {
+        std::int16_t* dst = out + static_cast<std::size_t>(f) * m_outputChannels;
+        if (m_buffering) {
+            conceal(a);
+            for (unsigned int c = 0; c < m_outputChannels; ++c) {
+                dst[c] = toSample(a[c]);
+            }
+            continue;
+        }
+
+        const double whole = std::floor(m_readPos);
+        const auto frame = static_cast<std::uint64_t>(whole);
+        const auto frac = static_cast<float>(m_readPos - whole);
+        const std::uint64_t packet = frame / m_packetFrames;
+        const bool present = fetchFrame(frame, a);
+        if (packet != m_lastCheckedPacket) {
+            m_lastCheckedPacket = packet;
+            if (!present) {
+                ++m_counters.lost;
+            }
+        }
+
+        if (present) {
+            m_lastGoodPacket = packet;
+            m_concealRun = 0;
+            if (f == 0) {
+                const Slot* slot = find(packet);
+                senderTimeNs = slot->senderTimeNs +
+                    static_cast<std::uint64_t>((m_readPos - static_cast<double>(packet * m_packetFrames)) * 1e9 / m_sampleRate);
+            }
+            if (frac > 0.f && fetchFrame(frame + 1, b)) {
+                for (unsigned int c = 0; c < m_outputChannels; ++c) {
+                    a[c] += (b[c] - a[c]) * frac;
+                }
+            }
+        } else {
+            conceal(a);
+        }
+        for (unsigned int c = 0; c < m_outputChannels; ++c) {
+            dst[c] = toSample(a[c]);
+        }
+
+        m_readPos += m_rate;
+        if (m_readPos + 1.0 > static_cast<double>((m_highestPacket + 1) * m_packetFrames)) {
+            // Caught up with the newest packet: hold here until the target delay is rebuilt
+            m_buffering = true;
+            ++m_counters.underruns;
+        }
+    }
+    return true;
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const {
+    Stats s = m_counters;
+    if (m_sampleRate > 0) {
+        s.jitterMs = m_jitterNs / 1e6;
+        s.targetMs = m_targetFrames * 1000.0 / m_sampleRate;
+        s.levelMs = std::max(0.0, m_started ? levelFrames() : 0.0) * 1000.0 / m_sampleRate;
+    }
+    s.rateRatio = m_rate;
+    return s;
+}
+
+void JitterBuffer::resetCounters() {
+    m_counters = Stats{};
+}
@@ -0,0 +1,43 @@
+#include "include/latency.hpp"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <utility>
+
+LatencyMonitor::LatencyMonitor(Clock::duration reportInterval, std::string label)
+    : m_reportInterval(reportInterval), m_label(std::move(label)), m_lastReport(Clock::now()) {
+    m_agesMs.reserve(1024);
+}
+
+void LatencyMonitor::recordPresent(Clock::time_point newestSample, Clock::time_point presentTime) {
+    if (newestSample == Clock::time_point{}) {
+        // No audio has been drawn yet
+        ++m_framesWithoutAudio;
+    } else {
+        std::chrono::duration<double, std::milli> age = presentTime - newestSample;
+        m_agesMs.push_back(age.count());
+    }
+
+    if (presentTime - m_lastReport >= m_reportInterval) {
+        report(presentTime);
+    }
+}
+
+void LatencyMonitor::report(Clock::time_point now) {
+    if (!m_agesMs.empty()) {
+        std::sort(m_agesMs.begin(), m_agesMs.end());
+        double mean = std::accumulate(m_agesMs.begin(), m_agesMs.end(), 0.0) / static_cast<double>(m_agesMs.size());
+        double p99 = m_agesMs[std::min(m_agesMs.size() - 1, (m_agesMs.size() * 99) / 100)];
+        std::cout << m_label << ": newest sample age at present over " << m_agesMs.size() << " frames: "
+                  << "min " << m_agesMs.front() << " ms, "
+                  << "mean " << mean << " ms, "
+                  << "p99 " << p99 << " ms, "
+                  << "max " << m_agesMs.back() << " ms" << std::endl;
+    }
+    if (m_framesWithoutAudio > 0) {
+        std::cout << m_label << ": " << m_framesWithoutAudio << " frames presented without audio" << std::endl;
+    }
+    m_agesMs.clear();
+    m_framesWithoutAudio = 0;
+    m_lastReport = now;
+}
@@ -1,190 +1,919 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 
 #include "include/oscilloscope.hpp"
 #include "include/osc.hpp"
+#include "include/renderer.hpp"
+#include "include/latency.hpp"
+#include "include/config.hpp"
+#include "include/capture.hpp"
+#include "include/rt_check.hpp"
+#include "include/udp_audio.hpp"
+#include "include/stream_aggregator.hpp"
+#include "include/quality_governor.hpp"
+#include "include/buffer_tuner.hpp"
+#include "osc/OscOutboundPacketStream.h"
 #include "RtAudio.h"
 
 constexpr size_t nScopes = 4;
+constexpr unsigned int nInputChannels = nScopes * 2;
 std::array<Oscilloscope, nScopes> scopes;
-std::vector<int16_t> audioBuffer;
+capture::CaptureRecorder recorder;
+// Fed with every callback's processing time; only acted on with --tune-latency
+BufferTuner bufferTuner;
+// Sample format of the audio input and the matching ingest specialization.
+// Set before audio starts flowing (or by the replay thread, the only producer in replay mode).
+SampleFormat inputFormat = SampleFormat::Int16;
+Oscilloscope::IngestFn scopeIngest = Oscilloscope::ingestFor(SampleFormat::Int16, nInputChannels);
+// Overflowed input blocks not yet reported by the main loop
+std::atomic<unsigned int> inputOverflows{0};
 
-// Audio callback function for RtAudio
+// Audio callback function for RtAudio. Must stay realtime-safe: no allocation,
+// locking or I/O (checked in RT_CHECK=1 builds).
 int audioCallback(void* /*outputBuffer*/, const void* inputBuffer, const unsigned int nFrames,
-    double /*streamTime*/, RtAudioStreamStatus status, void* /*userData*/) {
+    double streamTime, RtAudioStreamStatus status, void* /*userData*/) {
+    rtcheck::RealtimeSection realtime;
     if (status) {
-        std::cerr << "Stream overflow detected!" << std::endl;
+        inputOverflows.fetch_add(1, std::memory_order_relaxed);
     }
 
-    const auto* input = (const int16_t*)inputBuffer;
+    const auto* input = static_cast<const std::uint8_t*>(inputBuffer);
+    const auto captureTime = std::chrono::steady_clock::now();
+    recorder.recordAudio(inputBuffer, inputFormat, nFrames, nInputChannels, streamTime);
 
+    const std::size_t pairBytes = 2 * bytesPerSample(inputFormat);
     for (unsigned int i = 0; i < nScopes; ++i) {
-        // This temporary buffer is fine, as it's local to the audio thread.
-        std::vector<int16_t> scopeAudioBuffer;
-        scopeAudioBuffer.reserve(nFrames * 2);
+        // Each scope reads its channel pair straight out of the interleaved block
+        (scopes[i].*scopeIngest)(input + i * pairBytes, nFrames, nInputChannels, captureTime);
+    }
+
+    bufferTuner.recordCallback(std::chrono::steady_clock::now() - captureTime, status != 0);
+    return 0;
+}
+
+// Headless realtime-safety test: feeds synthetic blocks through the audio
+// callback while changing parameters and taking geometry the way the control
+// and render threads do, and fails if the callback allocated, locked or wrote.
+int runRealtimeSelfTest() {
+    if (!rtcheck::kEnabled) {
+        std::cerr << "Error: --rt-selftest needs a build with RT_CHECK=1." << std::endl;
+        return -1;
+    }
+
+    constexpr unsigned int nFrames = 256;
+    constexpr unsigned int nBlocks = 2000;
+    constexpr double sampleRate = 48000.0;
+    std::vector<int16_t> block(nFrames * nInputChannels);
+    for (auto& scope : scopes) {
+        scope.updateView({800, 600});
+    }
+
+    for (unsigned int b = 0; b < nBlocks; ++b) {
+        // A different Lissajous figure on every scope
         for (unsigned int j = 0; j < nFrames; ++j) {
-            scopeAudioBuffer.push_back(input[j * 8 + i * 2]);
-            scopeAudioBuffer.push_back(input[j * 8 + i * 2 + 1]);
+            const double t = static_cast<double>(b * nFrames + j) / sampleRate;
+            for (unsigned int i = 0; i < nScopes; ++i) {
+                block[j * nInputChannels + i * 2] = static_cast<int16_t>(16000.0 * std::sin(2.0 * M_PI * 110.0 * (i + 1) * t));
+                block[j * nInputChannels + i * 2 + 1] = static_cast<int16_t>(16000.0 * std::cos(2.0 * M_PI * 165.0 * (i + 1) * t));
+            }
+        }
+        const RtAudioStreamStatus status = (b % 500 == 499) ? RTAUDIO_INPUT_OVERFLOW : 0;
+        audioCallback(nullptr, block.data(), nFrames, b * nFrames / sampleRate, status, nullptr);
+
+        // Control thread: grow and shrink the history, recolor, resize, switch modes
+        Oscilloscope& scope = scopes[b % nScopes];
+        if (b % 100 == 50) {
+            scope.setPersistenceSamples((b / 100) % 2 ? 20000 : 5000);
+            scope.setTraceColor(sf::Color(static_cast<std::uint8_t>(b), 255, 128));
+            scope.updateView({640 + b % 400, 480});
+        }
+        // Cycle every scope through the render modes, with a new time base for each Y-T pass
+        if (b % 250 == 0) {
+            for (auto& s : scopes) {
+                s.setRenderMode(static_cast<RenderMode>((b / 250) % 3));
+                s.setTimeBase((b / 250) % 2 ? 0.5f : 0.005f);
+            }
+        }
+        scope.releaseRetiredBuffers();
+
+        // Render thread
+        for (auto& s : scopes) {
+            s.acquireGeometry(0);
         }
-        // Each scope's processSamples method handles its own thread safety.
-        scopes[i].processSamples(scopeAudioBuffer.data(), scopeAudioBuffer.size());
     }
 
-    return 0;
+    rtcheck::printSummary();
+    const std::uint64_t violations = rtcheck::violationCount();
+    std::cout << "RT self-test: " << nBlocks << " blocks of " << nFrames << " frames, "
+              << violations << " violations" << std::endl;
+    return violations == 0 ? 0 : -1;
 }
 
+// State shared between the event (main) thread and an output's render thread
+struct RenderThreadState {
+    std::atomic<bool> running{true};
+    std::atomic<bool> failed{false};
+    // Packed (width << 32 | height) of the last resize not yet applied, or 0
+    std::atomic<std::uint64_t> pendingSize{0};
+    std::atomic<std::uint64_t> frames{0};
+};
 
-int main() {
-    asio::io_context io_context;
-    OSCListener osc_listener_handler;
+// One render output: its scopes, target, thread and quality governor
+struct RenderOutput {
+    RenderOutput(const OutputSpec& spec, std::size_t index, double targetFrameMs, bool lockQuality)
+        : spec(spec), index(index), quality(targetFrameMs, lockQuality) {}
 
-    std::unique_ptr<AsioOscReceiver> osc_receiver;
-    try {
-        osc_receiver = std::make_unique<AsioOscReceiver>(io_context, osc_listener_handler);
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to initialize OSC receiver: " << e.what() << std::endl;
-        return -1;
+    OutputSpec spec;
+    std::size_t index;
+    std::vector<Oscilloscope*> scopes;
+    std::unique_ptr<sf::RenderWindow> window; // Window outputs: created and polled by the main thread
+    RenderThreadState state;
+    QualityGovernor quality;
+    std::thread thread;
+};
+
+// Render thread of one output: owns its GL context and does all drawing and presenting.
+// Scope geometry is shared read-only, so outputs never wait for each other.
+void renderLoop(RenderOutput& output, const RenderConfig& config, bool labelOutput, unsigned int densityThreads) {
+    RenderThreadState& state = output.state;
+    QualityGovernor& quality = output.quality;
+    const sf::Vector2u size(output.spec.width, output.spec.height);
+
+    std::optional<sf::RenderTexture> offscreen;
+    sf::RenderTarget* target = nullptr;
+    if (output.window) {
+        if (!output.window->setActive(true)) {
+            std::cerr << "Error: Could not activate the window context on the render thread." << std::endl;
+            state.failed = true;
+            return;
+        }
+        switch (config.framePacing) {
+            case FramePacing::VSync:
+                output.window->setVerticalSyncEnabled(true);
+                break;
+            case FramePacing::Limit:
+                output.window->setFramerateLimit(output.spec.frameRate);
+                break;
+            case FramePacing::Unlimited:
+                break;
+        }
+        target = output.window.get();
+    } else {
+        // Created on this thread, so its GL context is this thread's own
+        offscreen.emplace();
+        if (!offscreen->resize(size)) {
+            std::cerr << "Error: Could not create a " << size.x << "x" << size.y << " offscreen target." << std::endl;
+            state.failed = true;
+            return;
+        }
+        target = &*offscreen;
     }
 
-    std::thread asio_thread([&io_context]() {
-        try {
-            asio::executor_work_guard<asio::io_context::executor_type> work_guard = asio::make_work_guard(io_context);
-            io_context.run();
-        } catch (const std::exception& e) {
-            std::cerr << "Asio thread exception: " << e.what() << std::endl;
+    std::optional<Renderer> renderer;
+    renderer.emplace(output.index, densityThreads);
+    if (!renderer->init(target->getSize())) {
+        state.failed = true;
+        return;
+    }
+    if (!output.spec.shmName.empty()) {
+        renderer->enableExport(output.spec.shmName, config.exportSlotCount);
+    }
+
+    std::optional<LatencyMonitor> latency;
+    if (config.measureLatency) {
+        latency.emplace(std::chrono::seconds(1),
+                        labelOutput ? "Latency (output " + std::to_string(output.index) + ")" : "Latency");
+    }
+
+    // Offscreen outputs have no display to pace them
+    const bool paceOffscreen = !output.window && output.spec.frameRate > 0 && config.framePacing != FramePacing::Unlimited;
+    const auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(paceOffscreen ? 1.0 / output.spec.frameRate : 0.0));
+    auto nextFrame = std::chrono::steady_clock::now();
+
+    // Forces the settings of the governor's level to be applied before the first frame
+    unsigned int appliedLevel = QualityGovernor::kLevelCount;
+    auto lastPresent = std::chrono::steady_clock::now();
+
+    while (state.running) {
+        if (std::uint64_t packed = state.pendingSize.exchange(0)) {
+            sf::Vector2u sizeVec = {static_cast<unsigned int>(packed >> 32), static_cast<unsigned int>(packed)};
+            sf::FloatRect viewRect({0.f, 0.f}, {static_cast<float>(sizeVec.x), static_cast<float>(sizeVec.y)});
+            target->setView(sf::View(viewRect));
+            renderer->resize(sizeVec);
         }
-    });
 
-    unsigned int width = 800;
-    unsigned int height = 600;
+        if (const unsigned int level = quality.level(); level != appliedLevel) {
+            const QualitySettings& settings = QualityGovernor::settings(level);
+            renderer->setQuality(settings);
+            for (Oscilloscope* scope : output.scopes) {
+                scope->setPointStride(output.index, settings.pointStride);
+            }
+            appliedLevel = level;
+        }
+
+        const auto frameStart = std::chrono::steady_clock::now();
+        target->clear(sf::Color::Transparent);
+        auto newestSample = renderer->render(*target, output.scopes);
+        const auto renderEnd = std::chrono::steady_clock::now();
+        if (output.window) {
+            output.window->display();
+        } else {
+            offscreen->display();
+            if (paceOffscreen) {
+                nextFrame = std::max(nextFrame + framePeriod, renderEnd);
+                std::this_thread::sleep_until(nextFrame);
+            }
+        }
+        const auto presented = std::chrono::steady_clock::now();
+        state.frames.fetch_add(1, std::memory_order_relaxed);
+
+        if (latency) {
+            latency->recordPresent(newestSample, presented);
+        }
+
+        // Work is what this frame cost the CPU: rendering here, strip building on the
+        // audio thread. GPU overload surfaces as late frames instead.
+        auto work = renderEnd - frameStart;
+        for (Oscilloscope* scope : output.scopes) {
+            work += scope->takeGeometryBuildTime(output.index);
+        }
+        const double frameMs = std::chrono::duration<double, std::milli>(presented - lastPresent).count();
+        const double workMs = std::chrono::duration<double, std::milli>(work).count();
+        lastPresent = presented;
+        if (quality.update(frameMs, workMs, presented)) {
+            const QualitySettings& settings = QualityGovernor::settings(quality.level());
+            std::cout << "Quality" << (labelOutput ? " (output " + std::to_string(output.index) + ")" : std::string())
+                      << ": level " << quality.level() << "/" << QualityGovernor::kLevelCount - 1
+                      << " (point stride " << settings.pointStride << ", blur taps " << settings.blurTaps
+                      << ", render scale " << settings.renderScale << "), frame " << quality.averageFrameMs()
+                      << " ms, work " << quality.averageWorkMs() << " ms" << std::endl;
+        }
+    }
+
+    // The renderer and its exporter free GL objects, so they go before the context is released
+    renderer.reset();
+    if (output.window) {
+        (void)output.window->setActive(false);
+    }
+}
+
+
+// Sends an output's quality governor state to an OSC client:
+// /quality output level max_level locked frame_ms work_ms target_ms point_stride blur_taps render_scale
+void sendQualityReport(AsioOscReceiver& receiver, const IpEndpointName& destination, const RenderOutput& output) {
+    char buffer[256];
+    osc::OutboundPacketStream packet(buffer, sizeof(buffer));
+    const QualityGovernor& quality = output.quality;
+    const unsigned int level = quality.level();
+    const QualitySettings& settings = QualityGovernor::settings(level);
+    packet << osc::BeginMessage("/quality") << static_cast<osc::int32>(output.index)
+           << static_cast<osc::int32>(level) << static_cast<osc::int32>(QualityGovernor::kLevelCount - 1)
+           << static_cast<osc::int32>(quality.isLocked())
+           << static_cast<float>(quality.averageFrameMs()) << static_cast<float>(quality.averageWorkMs())
+           << static_cast<float>(quality.targetFrameMs())
+           << static_cast<osc::int32>(settings.pointStride) << static_cast<osc::int32>(settings.blurTaps)
+           << settings.renderScale << osc::EndMessage;
+    receiver.send(destination, packet.Data(), packet.Size());
+}
+
+// Sends one scope's memory use to an OSC client:
+// /memory scope quota_bytes used_bytes persistence_samples max_persistence_samples density_bytes
+void sendMemoryReport(AsioOscReceiver& receiver, const IpEndpointName& destination, std::size_t index,
+                      const Oscilloscope& scope) {
+    char buffer[128];
+    osc::OutboundPacketStream packet(buffer, sizeof(buffer));
+    packet << osc::BeginMessage("/memory") << static_cast<osc::int32>(index)
+           << static_cast<osc::int64>(scope.getMemoryQuota()) << static_cast<osc::int64>(scope.getMemoryUsage())
+           << static_cast<osc::int32>(scope.getPersistenceSamples())
+           << static_cast<osc::int32>(scope.getMaxPersistenceSamples())
+           << static_cast<osc::int64>(scope.getDensityMemory()) << osc::EndMessage;
+    receiver.send(destination, packet.Data(), packet.Size());
+}
+
+RtAudioFormat toRtAudioFormat(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int24: return RTAUDIO_SINT24;
+        case SampleFormat::Int32: return RTAUDIO_SINT32;
+        case SampleFormat::Float32: return RTAUDIO_FLOAT32;
+        case SampleFormat::Int16: break;
+    }
+    return RTAUDIO_SINT16;
+}
+
+// Picks the device's native format so RtAudio delivers samples unconverted,
+// preferring the widest one. Falls back to int16, which RtAudio can always convert to.
+SampleFormat chooseSampleFormat(RtAudioFormat nativeFormats) {
+    for (SampleFormat format : {SampleFormat::Float32, SampleFormat::Int32, SampleFormat::Int24, SampleFormat::Int16}) {
+        if (nativeFormats & toRtAudioFormat(format)) {
+            return format;
+        }
+    }
+    return SampleFormat::Int16;
+}
+
+// Signature of audioCallback() and the other input callbacks handed to RtAudio
+using InputCallback = int (*)(void*, const void*, unsigned int, double, RtAudioStreamStatus, void*);
 
+// An opened RtAudio input stream, with what it takes to reopen it
+struct AudioInput {
+    std::unique_ptr<RtAudio> audio;
+    unsigned int sampleRate = 0;
+    unsigned int bufferFrames = 0;
+    SampleFormat format = SampleFormat::Int16;
     RtAudio::StreamParameters params;
+    RtAudio::StreamOptions options;
+    InputCallback callback = nullptr;
+    void* userData = nullptr;
+};
+
+// Finds an input device whose name contains the given text. An empty name means the platform default.
+std::optional<unsigned int> findInputDevice(RtAudio& audio, std::string name) {
 #ifdef __APPLE__
-    // --- RtAudio Setup for macOS using CoreAudio ---
-    RtAudio audio;
-    if (audio.getDeviceCount() < 1) {
-        std::cerr << "Error: No audio devices found." << std::endl;
-        return -1;
+    if (name.empty()) {
+        name = "BlackHole";
     }
-
-    // Find the BlackHole audio device
-    unsigned int blackHoleDeviceId = 0;
-    std::vector<unsigned int> deviceIds = audio.getDeviceIds();
-    for (unsigned int i : deviceIds) {
+#else
+    if (name.empty()) {
+        return audio.getDefaultInputDevice();
+    }
+#endif
+    for (unsigned int i : audio.getDeviceIds()) {
         try {
             RtAudio::DeviceInfo info = audio.getDeviceInfo(i);
             std::cout << "Found device: " << info.name << " with ID: " << i << std::endl;
-            if (std::string(info.name).find("BlackHole") != std::string::npos) {
-                blackHoleDeviceId = i;
-                break;
+            if (std::string(info.name).find(name) != std::string::npos) {
+                return i;
             }
         } catch (const RtAudioErrorType& e) {
             std::cerr << "Error getting device info for device " << i << ": " << e << std::endl;
         }
     }
 
-    if (blackHoleDeviceId == 0) {
+#ifdef __APPLE__
+    if (name == "BlackHole") {
         std::cerr << "Error: BlackHole audio device not found." << std::endl;
         std::cerr << "Please install BlackHole from https://github.com/ExistentialAudio/BlackHole" << std::endl;
-        return -1;
+        return std::nullopt;
     }
+#endif
+    std::cerr << "Error: No audio device matching '" << name << "' found." << std::endl;
+    return std::nullopt;
+}
 
-    params.deviceId = blackHoleDeviceId;
+// Opens an RtAudio input stream on the named device (empty for the default) without starting it.
+std::optional<AudioInput> openAudioInput(const std::string& deviceName, unsigned int nChannels,
+                                         std::optional<SampleFormat> requestedFormat, unsigned int bufferFrames,
+                                         const std::string& streamName, InputCallback callback, void* userData) {
+    AudioInput input;
+#ifdef __APPLE__
+    // --- RtAudio Setup for macOS using CoreAudio ---
+    input.audio = std::make_unique<RtAudio>();
+    if (input.audio->getDeviceCount() < 1) {
+        std::cerr << "Error: No audio devices found." << std::endl;
+        return std::nullopt;
+    }
 #else
     // --- RtAudio Setup using JACK Backend (for Linux) ---
-    RtAudio audio(RtAudio::UNIX_JACK);
-    if (audio.getDeviceCount() < 1) {
+    input.audio = std::make_unique<RtAudio>(RtAudio::UNIX_JACK);
+    if (input.audio->getDeviceCount() < 1) {
         std::cerr << "Error: No audio devices found by the JACK backend.\n"
                   << "Please ensure the PipeWire-JACK compatibility layer is running." << std::endl;
-        return -1;
+        return std::nullopt;
     }
-    params.deviceId = audio.getDefaultInputDevice();
 #endif
-    
-    
-    params.nChannels = 8;
+    RtAudio& audio = *input.audio;
+
+    RtAudio::StreamParameters& params = input.params;
+    const std::optional<unsigned int> deviceId = findInputDevice(audio, deviceName);
+    if (!deviceId) {
+        return std::nullopt;
+    }
+    params.deviceId = *deviceId;
+    params.nChannels = nChannels;
     params.firstChannel = 0;
-    unsigned int bufferFrames = 256;
+    input.bufferFrames = bufferFrames;
 
-    // Query the default input device for its preferred sample rate
+    // Query the input device for its preferred sample rate
     RtAudio::DeviceInfo info = audio.getDeviceInfo(params.deviceId);
-    unsigned int sampleRate = info.preferredSampleRate;
-    if (sampleRate == 0) {
+    input.sampleRate = info.preferredSampleRate;
+    if (input.sampleRate == 0) {
         std::cerr << "Warning: Could not determine preferred sample rate from JACK. Falling back to 44100." << std::endl;
-        sampleRate = 44100; // Fallback
+        input.sampleRate = 44100; // Fallback
     }
-    std::cout << "Using sample rate: " << sampleRate << std::endl;
+    std::cout << "Using sample rate: " << input.sampleRate << std::endl;
 
-#ifdef __APPLE__
-    // For macOS, use default stream options
-    RtAudio::StreamOptions options;
-    try {
-        audio.openStream(nullptr, &params, RTAUDIO_SINT16, sampleRate, &bufferFrames, &audioCallback, nullptr, &options);
-        audio.startStream();
-        std::cout << "Successfully opened CoreAudio input stream." << std::endl;
-    }
-#else
+    input.format = requestedFormat ? *requestedFormat : chooseSampleFormat(info.nativeFormats);
+    const RtAudioFormat streamFormat = toRtAudioFormat(input.format);
+    std::cout << "Using sample format: " << sampleFormatName(input.format)
+              << ((info.nativeFormats & streamFormat) ? " (native)" : " (converted by RtAudio)") << std::endl;
+
+    RtAudio::StreamOptions& options = input.options;
+    input.callback = callback;
+    input.userData = userData;
+#ifndef __APPLE__
     // For Linux, use JACK-specific stream options
-    RtAudio::StreamOptions options;
     options.flags = RTAUDIO_JACK_DONT_CONNECT;
-    options.streamName = "OSCAR Renderer";
+    options.streamName = streamName;
+#else
+    (void)streamName;
+#endif
 
     try {
-        audio.openStream(NULL, &params, RTAUDIO_SINT16, sampleRate, &bufferFrames, &audioCallback, NULL, &options);
-        audio.startStream();
+        audio.openStream(nullptr, &params, streamFormat, input.sampleRate, &input.bufferFrames, callback, userData, &options);
+#ifdef __APPLE__
+        std::cout << "Successfully opened CoreAudio input stream." << std::endl;
+#else
         std::cout << "Successfully opened JACK input stream." << std::endl;
         std::cout << "Application should be visible in qjackctl or qpwgraph as '" << options.streamName << "'." << std::endl;
-    }
 #endif
-    catch (const std::exception& e) {
+    } catch (const std::exception& e) {
         std::cerr << "Error opening audio stream: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    return input;
+}
+
+bool startAudioInput(AudioInput& input) {
+    try {
+        input.audio->startStream();
+    } catch (const std::exception& e) {
+        std::cerr << "Error starting audio stream: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Closes a running input and opens it again with a new buffer size. The
+// backend may grant a different size (JACK always uses its own period).
+bool reopenAudioInput(AudioInput& input, unsigned int bufferFrames) {
+    RtAudio& audio = *input.audio;
+    try {
+        if (audio.isStreamRunning()) {
+            audio.stopStream();
+        }
+        if (audio.isStreamOpen()) {
+            audio.closeStream();
+        }
+        unsigned int frames = bufferFrames;
+        audio.openStream(nullptr, &input.params, toRtAudioFormat(input.format), input.sampleRate, &frames,
+                         input.callback, input.userData, &input.options);
+        if (!audio.isStreamOpen()) {
+            std::cerr << "Error reopening audio stream with " << bufferFrames << " frames." << std::endl;
+            return false;
+        }
+        input.bufferFrames = frames;
+    } catch (const std::exception& e) {
+        std::cerr << "Error reopening audio stream: " << e.what() << std::endl;
+        return false;
+    }
+    return startAudioInput(input);
+}
+
+void printBufferReport(const BufferTuner& tuner) {
+    const BufferTuner::Report& report = tuner.report();
+    std::cout << "Buffer: " << report.bufferFrames << " frames (" << report.periodMs << " ms), callback "
+              << report.medianMs << " ms median, " << report.peakMs << " ms peak, margin "
+              << 100.0 * report.margin << "% (want " << 100.0 * tuner.margin() << "%), "
+              << report.overflows << " overflows";
+    if (report.recommendedFrames != report.bufferFrames) {
+        std::cout << ", best size " << report.recommendedFrames << " frames";
+    }
+    std::cout << std::endl;
+}
+
+// One of several device streams merged by a StreamAggregator (--stream)
+struct AggregatedInput {
+    StreamAggregator* aggregator = nullptr;
+    std::size_t index = 0;
+    unsigned int nChannels = 0;
+    SampleFormat format = SampleFormat::Int16;
+    AudioInput input;
+};
+
+// RtAudio callback of an aggregated stream. The master stream's call ends in audioCallback().
+int aggregatedInputCallback(void* /*outputBuffer*/, const void* inputBuffer, const unsigned int nFrames,
+    double streamTime, RtAudioStreamStatus status, void* userData) {
+    rtcheck::RealtimeSection realtime;
+    if (status) {
+        inputOverflows.fetch_add(1, std::memory_order_relaxed);
+    }
+    const auto* stream = static_cast<const AggregatedInput*>(userData);
+    stream->aggregator->streamInput(stream->index, inputBuffer, stream->format, nFrames, stream->nChannels, streamTime,
+                                    std::chrono::steady_clock::now());
+    return 0;
+}
+
+// Opens one RtAudio stream per --stream spec and merges them onto the first stream's clock.
+bool openAggregatedInputs(const RenderConfig& config, std::unique_ptr<StreamAggregator>& aggregator,
+                          std::vector<std::unique_ptr<AggregatedInput>>& streams) {
+    std::array<bool, nScopes> mapped{};
+    for (const InputStreamSpec& spec : config.inputStreams) {
+        for (unsigned int scope : spec.scopes) {
+            if (scope >= nScopes || mapped[scope]) {
+                std::cerr << "Error: Scope " << scope << " is out of range or fed by more than one stream." << std::endl;
+                return false;
+            }
+            mapped[scope] = true;
+        }
+    }
+
+    // The aggregate block is float; replay and recording see it like any other input
+    inputFormat = SampleFormat::Float32;
+    scopeIngest = Oscilloscope::ingestFor(inputFormat, nInputChannels);
+    aggregator = std::make_unique<StreamAggregator>(nInputChannels, 3.0,
+        [](const float* frames, unsigned int nFrames, unsigned int, double streamTime) {
+            audioCallback(nullptr, frames, nFrames, streamTime, 0, nullptr);
+        });
+
+    for (std::size_t i = 0; i < config.inputStreams.size(); ++i) {
+        const InputStreamSpec& spec = config.inputStreams[i];
+        auto stream = std::make_unique<AggregatedInput>();
+        stream->aggregator = aggregator.get();
+        stream->nChannels = static_cast<unsigned int>(spec.scopes.size() * 2);
+        std::optional<AudioInput> input = openAudioInput(spec.device, stream->nChannels, config.sampleFormat,
+                                                         config.bufferFrames, "OSCAR Renderer " + std::to_string(i + 1),
+                                                         &aggregatedInputCallback, stream.get());
+        if (!input) {
+            return false;
+        }
+        stream->input = std::move(*input);
+        stream->format = stream->input.format;
+        stream->index = aggregator->addStream(spec.scopes, stream->input.sampleRate, stream->input.bufferFrames);
+        if (i == 0) {
+            // Every stream is resampled to the master's rate
+            for (auto& scope : scopes) {
+                scope.setSampleRate(stream->input.sampleRate);
+            }
+            recorder.setSampleRate(stream->input.sampleRate);
+        }
+        streams.push_back(std::move(stream));
+    }
+
+    // Slaves first, so their rings are filling by the time the master starts pulling
+    for (auto it = streams.rbegin(); it != streams.rend(); ++it) {
+        if (!startAudioInput((*it)->input)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printAggregatorStats(const StreamAggregator& aggregator) {
+    for (std::size_t i = 1; i < aggregator.streamCount(); ++i) {
+        const StreamAggregator::StreamStats stats = aggregator.stats(i);
+        std::cout << "Stream " << i + 1 << ": drift " << stats.driftPpm << " ppm, buffer " << stats.levelMs << "/"
+                  << stats.targetMs << " ms, " << stats.underruns << " underruns, " << stats.overflows
+                  << " frames dropped" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    rtcheck::init();
+
+    std::optional<RenderConfig> config = parseCommandLine(argc, argv);
+    if (!config) {
         return -1;
     }
-    
+    if (config->rtSelfTest) {
+        return runRealtimeSelfTest();
+    }
+
+    // Outputs and the scopes they show; per-output scope state must exist before audio starts
+    std::vector<std::unique_ptr<RenderOutput>> outputs;
+    for (const OutputSpec& spec : config->outputs) {
+        const std::size_t index = outputs.size();
+        const unsigned int frameRate = spec.frameRate > 0 ? spec.frameRate : config->frameRateLimit;
+        auto output = std::make_unique<RenderOutput>(spec, index, config->targetFrameMs.value_or(1000.0 / frameRate),
+                                                     config->lockQuality);
+        if (index == 0 && output->spec.shmName.empty()) {
+            output->spec.shmName = config->exportShmName;
+        }
+        std::vector<unsigned int> shown = spec.scopes;
+        if (shown.empty()) {
+            for (unsigned int i = 0; i < nScopes; ++i) {
+                shown.push_back(i);
+            }
+        }
+        for (unsigned int scope : shown) {
+            if (scope >= nScopes) {
+                std::cerr << "Error: Output " << index << " shows scope " << scope << ", which does not exist." << std::endl;
+                return -1;
+            }
+            output->scopes.push_back(&scopes[scope]);
+            scopes[scope].attachOutput(index);
+        }
+        outputs.push_back(std::move(output));
+    }
+
+    // Each scope gets an equal share of the memory budget, which bounds its
+    // persistence whatever arrives over OSC
+    const std::size_t scopeQuota = config->memoryBudget / nScopes;
+    for (unsigned int i = 0; i < nScopes; ++i) {
+        if (scopes[i].memoryFor(1) > scopeQuota) {
+            std::cerr << "Error: --memory-budget is too small for these outputs; it needs at least "
+                      << (nScopes * scopes[i].memoryFor(1) >> 20) + 1 << " MB." << std::endl;
+            return -1;
+        }
+        scopes[i].setMemoryQuota(scopeQuota);
+    }
+    std::cout << "Memory: " << (config->memoryBudget >> 20) << " MB budget, " << (scopeQuota >> 20)
+              << " MB per scope, persistence up to " << scopes[0].getMaxPersistenceSamples() << " samples" << std::endl;
+
+    // In replay mode, audio and OSC come from the capture file instead of the live sources
+    const bool replaying = !config->replayPath.empty();
+    capture::CaptureReplayer replayer;
+    if (replaying && !replayer.open(config->replayPath)) {
+        return -1;
+    }
+    if (replaying) {
+        // Timing must follow the recording, so the rate is set before the replay thread starts
+        if (replayer.sampleRate() != 0) {
+            for (auto& scope : scopes) {
+                scope.setSampleRate(replayer.sampleRate());
+            }
+        } else {
+            std::cerr << "Replay: " << config->replayPath << " does not record its sample rate, assuming "
+                      << scopes[0].getSampleRate() << " Hz" << std::endl;
+        }
+    }
+
+    asio::io_context io_context;
+    OSCListener osc_listener_handler;
+
+    std::unique_ptr<AsioOscReceiver> osc_receiver;
+    if (!replaying) {
+        try {
+            osc_receiver = std::make_unique<AsioOscReceiver>(io_context, osc_listener_handler);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to initialize OSC receiver: " << e.what() << std::endl;
+            return -1;
+        }
+    }
+
+    if (!config->recordPath.empty()) {
+        if (!recorder.start(config->recordPath, 16 << 20, 1 << 20)) {
+            return -1;
+        }
+        osc_receiver->setPacketObserver([](const char* data, std::size_t size) {
+            recorder.recordOsc(data, size);
+        });
+    }
+
+    std::thread asio_thread([&io_context]() {
+        try {
+            asio::executor_work_guard<asio::io_context::executor_type> work_guard = asio::make_work_guard(io_context);
+            io_context.run();
+        } catch (const std::exception& e) {
+            std::cerr << "Asio thread exception: " << e.what() << std::endl;
+        }
+    });
+
+    std::optional<AudioInput> device_input;
+    std::unique_ptr<udpaudio::UdpAudioReceiver> udp_input;
+    std::unique_ptr<StreamAggregator> aggregator;
+    std::vector<std::unique_ptr<AggregatedInput>> aggregated_inputs;
+    if (replaying) {
+        // Audio comes from the replay thread started below
+    } else if (config->inputSource == InputSource::Udp) {
+        // The receiver's playout thread stands in for the RtAudio callback
+        udp_input = std::make_unique<udpaudio::UdpAudioReceiver>(
+            static_cast<unsigned short>(config->udpPort), nInputChannels, 256, 2.0, 200.0,
+            [](const std::int16_t* samples, unsigned int nFrames, unsigned int, double streamTime) {
+                audioCallback(nullptr, samples, nFrames, streamTime, 0, nullptr);
+            });
+        udp_input->setReportStats(config->measureLatency);
+        if (!udp_input->start()) {
+            return -1;
+        }
+    } else if (!config->inputStreams.empty()) {
+        if (!openAggregatedInputs(*config, aggregator, aggregated_inputs)) {
+            return -1;
+        }
+    } else {
+        device_input = openAudioInput("", nInputChannels, config->sampleFormat, config->bufferFrames, "OSCAR Renderer",
+                                      &audioCallback, nullptr);
+        if (!device_input) {
+            return -1;
+        }
+        inputFormat = device_input->format;
+        scopeIngest = Oscilloscope::ingestFor(inputFormat, nInputChannels);
+        for (auto& scope : scopes) {
+            scope.setSampleRate(device_input->sampleRate);
+        }
+        recorder.setSampleRate(device_input->sampleRate);
+        if (!startAudioInput(*device_input)) {
+            return -1;
+        }
+    }
+
+    // Buffer tuning needs a stream it can reopen, so only the single device input qualifies
+    const bool tuning_buffer = config->tuneLatency && device_input;
+    if (tuning_buffer) {
+        const bool sizeFixed = device_input->bufferFrames != config->bufferFrames;
+        bufferTuner.setMargin(config->latencyMargin);
+        bufferTuner.start(device_input->bufferFrames, device_input->sampleRate, sizeFixed, std::chrono::steady_clock::now());
+        if (sizeFixed) {
+            std::cout << "Buffer: The backend chose " << device_input->bufferFrames
+                      << " frames; reporting the best size only (on JACK, set it with jack_bufsize)." << std::endl;
+        }
+    } else if (config->tuneLatency) {
+        std::cerr << "Warning: --tune-latency only applies to a single audio device input; ignored." << std::endl;
+    }
+
     // --- SFML 3 API Setup ---
     sf::ContextSettings ctx;
-    sf::RenderWindow window(sf::VideoMode({width, height}), "OSCAR", sf::State::Windowed, ctx);
-    window.setFramerateLimit(60);
+    RenderOutput* reference = nullptr;
+    for (auto& output : outputs) {
+        if (output->spec.kind != OutputKind::Window) {
+            continue;
+        }
+        const std::string title = outputs.size() > 1 ? "OSCAR " + std::to_string(output->index) : "OSCAR";
+        output->window = std::make_unique<sf::RenderWindow>(sf::VideoMode({output->spec.width, output->spec.height}),
+                                                            title, sf::State::Windowed, ctx);
+        // Hand the GL context over to the render thread; this thread only handles events and OSC
+        (void)output->window->setActive(false);
+        if (!reference) {
+            reference = output.get();
+        }
+    }
+
+    // Geometry is laid out in the pixels of the first window (or of the first
+    // output when all are offscreen); other outputs map it onto their own size
+    if (!reference) {
+        reference = outputs.front().get();
+    }
+    const sf::Vector2u referenceSize = reference->window ? reference->window->getSize()
+                                                         : sf::Vector2u(reference->spec.width, reference->spec.height);
     for (unsigned int i=0; i<nScopes; i++) {
-        scopes[i].updateView(window.getSize());
+        scopes[i].updateView(referenceSize);
     }
 
-    sf::RenderTexture traceTexture({width, height});
-    sf::RenderTexture compositeTexture({width, height});
-    sf::RenderTexture blurTexture({width, height});
-    sf::RenderTexture frameTexture({width, height});
+    const bool labelOutputs = outputs.size() > 1;
+    // Every output bins density on its own pool, so split the cores between them
+    const unsigned int densityThreads = std::max<unsigned int>(
+        1u, std::thread::hardware_concurrency() / static_cast<unsigned int>(outputs.size()));
+    const auto render_start = std::chrono::steady_clock::now();
+    for (auto& output : outputs) {
+        output->thread = std::thread(renderLoop, std::ref(*output), std::cref(*config), labelOutputs,
+                                     densityThreads);
+    }
 
-    sf::Shader gaussianBlurShader;
-    if (!gaussianBlurShader.loadFromFile("blur.frag", sf::Shader::Type::Fragment)) {
-        std::cerr << "Error: Could not load blur.frag shader." << std::endl;
-        return -1;
+    // The replay thread stands in for both the audio callback and the OSC thread
+    std::atomic<bool> replay_done{false};
+    std::atomic<bool> stop_replay{false};
+    std::thread replay_thread;
+    if (replaying) {
+        replay_thread = std::thread([&]() {
+            bool warned = false;
+            replayer.run(config->replaySpeed,
+                [&warned](const void* samples, SampleFormat format, unsigned int nFrames, unsigned int nChannels, double streamTime) {
+                    if (nChannels != nInputChannels) {
+                        if (!warned) {
+                            std::cerr << "Replay: skipping audio blocks with " << nChannels << " channels (expected "
+                                      << nInputChannels << ")" << std::endl;
+                            warned = true;
+                        }
+                        return;
+                    }
+                    if (format != inputFormat) {
+                        inputFormat = format;
+                        scopeIngest = Oscilloscope::ingestFor(format, nInputChannels);
+                    }
+                    audioCallback(nullptr, samples, nFrames, streamTime, 0, nullptr);
+                },
+                [&osc_listener_handler](const char* data, std::size_t size) {
+                    try {
+                        osc_listener_handler.ProcessPacket(data, static_cast<int>(size), IpEndpointName());
+                    } catch (const osc::Exception& e) {
+                        std::cerr << "Replay: oscpack parsing error in ProcessPacket: " << e.what() << std::endl;
+                    }
+                },
+                stop_replay);
+            replay_done = true;
+        });
     }
-    gaussianBlurShader.setUniform("texture", sf::Shader::CurrentTexture);
 
-    while (window.isOpen()) {
-        // SFML 3 Event Loop
-        while (const auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                window.close();
+    bool close_requested = false;
+    auto handleEvent = [&](RenderOutput& output, const sf::Event& event) {
+        if (event.is<sf::Event::Closed>()) {
+            close_requested = true;
+        }
+
+        if (const auto* resized = event.getIf<sf::Event::Resized>()) {
+            output.state.pendingSize = (static_cast<std::uint64_t>(resized->size.x) << 32) | resized->size.y;
+            if (&output == reference) {
+                for (auto& scope : scopes) {
+                    scope.updateView(resized->size);
+                }
             }
+        }
+    };
+    auto outputFailed = [&outputs]() {
+        return std::any_of(outputs.begin(), outputs.end(), [](const auto& output) { return output->state.failed.load(); });
+    };
 
-            if (const auto* resized = event->getIf<sf::Event::Resized>()) {
-                sf::Vector2u sizeVec = {resized->size.x, resized->size.y};
-                sf::FloatRect viewRect({0.f, 0.f}, {static_cast<float>(sizeVec.x), static_cast<float>(sizeVec.y)});
-                window.setView(sf::View(viewRect));
-                traceTexture = sf::RenderTexture(sizeVec);
-                blurTexture = sf::RenderTexture(sizeVec);
-                frameTexture = sf::RenderTexture(sizeVec);
-                compositeTexture = sf::RenderTexture(sizeVec);
-                for (unsigned int i=0; i<nScopes; i++) {
-                    scopes[i].updateView(sizeVec);
+    auto last_stream_report = std::chrono::steady_clock::now();
+    unsigned int udp_sample_rate = 0;
+    std::vector<std::uint64_t> reported_frames(outputs.size(), 0);
+    unsigned int reported_buffer_frames = 0;
+    // The last client to query /quality also hears about every later level change
+    std::optional<IpEndpointName> quality_subscriber;
+    std::vector<unsigned int> reported_quality_levels(outputs.size(), QualityGovernor::kLevelCount);
+
+    // A finished replay closes the renderer so benchmark runs terminate on their own
+    while (!close_requested && !outputFailed() && !replay_done) {
+        // SFML 3 Event Loop. The timeout bounds how stale OSC parameters can get.
+        bool waited = false;
+        for (auto& output : outputs) {
+            if (!output->window) {
+                continue;
+            }
+            if (!waited) {
+                if (const auto event = output->window->waitEvent(sf::milliseconds(5))) {
+                    handleEvent(*output, *event);
                 }
+                waited = true;
             }
+            while (const auto next = output->window->pollEvent()) {
+                handleEvent(*output, *next);
+            }
+        }
+        if (!waited) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        // The UDP stream's rate is only known once it has locked on, and the sender may switch it later
+        if (const unsigned int rate = udp_input ? udp_input->sampleRate() : 0; rate != 0 && rate != udp_sample_rate) {
+            udp_sample_rate = rate;
+            for (auto& scope : scopes) {
+                scope.setSampleRate(rate);
+            }
+            recorder.setSampleRate(rate);
+            std::cout << "UDP input: " << rate << " Hz" << std::endl;
         }
+        if (unsigned int overflows = inputOverflows.exchange(0, std::memory_order_relaxed)) {
+            std::cerr << "Stream overflow detected! (" << overflows << " blocks)" << std::endl;
+        }
+        if (config->measureLatency && std::chrono::steady_clock::now() - last_stream_report >= std::chrono::seconds(1)) {
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - last_stream_report).count();
+            if (aggregator) {
+                printAggregatorStats(*aggregator);
+            }
+            if (labelOutputs) {
+                for (std::size_t i = 0; i < outputs.size(); ++i) {
+                    const std::uint64_t frames = outputs[i]->state.frames.load(std::memory_order_relaxed);
+                    std::cout << "Output " << i << ": " << (frames - reported_frames[i]) / elapsed << " fps" << std::endl;
+                    reported_frames[i] = frames;
+                }
+            }
+            last_stream_report = std::chrono::steady_clock::now();
+        }
+        if (tuning_buffer && bufferTuner.evaluate(std::chrono::steady_clock::now())) {
+            const BufferTuner::Report& report = bufferTuner.report();
+            if (config->measureLatency || report.reopen || report.recommendedFrames != reported_buffer_frames) {
+                printBufferReport(bufferTuner);
+                reported_buffer_frames = report.recommendedFrames;
+            }
+            if (report.reopen) {
+                const unsigned int previous = device_input->bufferFrames;
+                const unsigned int requested = report.recommendedFrames;
+                // The size is only fixed if the backend chose another one in the call that succeeded
+                unsigned int opened = requested;
+                if (!reopenAudioInput(*device_input, requested)) {
+                    opened = previous;
+                    if (!reopenAudioInput(*device_input, previous)) {
+                        std::cerr << "Error: Audio input lost while changing the buffer size." << std::endl;
+                        break;
+                    }
+                }
+                const bool sizeFixed = device_input->bufferFrames != opened;
+                const auto now = std::chrono::steady_clock::now();
+                bufferTuner.start(device_input->bufferFrames, device_input->sampleRate, sizeFixed, now);
+                if (opened != requested) {
+                    bufferTuner.rejectSize(requested, now);
+                    std::cout << "Buffer: " << requested << " frames refused, kept " << device_input->bufferFrames
+                              << " frames (not tried again for a minute)" << std::endl;
+                }
+                if (opened == requested || sizeFixed) {
+                    std::cout << "Buffer: Reopened with " << device_input->bufferFrames << " frames"
+                              << (sizeFixed ? " (size chosen by the backend; no further changes)" : "") << std::endl;
+                }
+            }
+        }
+        for (auto& scope : scopes) {
+            scope.releaseRetiredBuffers();
+        }
+
         int scope_index = osc_listener_handler.getIndex();
 
         if (auto val_opt = osc_listener_handler.getPendingTraceThickness()) {
@@ -209,7 +938,14 @@ int main() {
         if (auto val_opt = osc_listener_handler.getPendingPersistenceSamples()) {
             if (val_opt) {
                 scopes[scope_index].setPersistenceSamples(*val_opt);
+                if (tuning_buffer) {
+                    bufferTuner.noteLoadChange(std::chrono::steady_clock::now());
+                }
                 std::cout << "Main: Applied Persistence Frames set to: " << scopes[scope_index].getPersistenceSamples() << std::endl;
+                if (scopes[scope_index].getPersistenceSamples() < *val_opt) {
+                    std::cerr << "Main: Persistence of " << *val_opt << " does not fit scope " << scope_index
+                              << "'s memory quota of " << (scopes[scope_index].getMemoryQuota() >> 20) << " MB" << std::endl;
+                }
             }
         }
 
@@ -241,34 +977,118 @@ int main() {
             }
         }
 
-        window.clear(sf::Color::Transparent);
+        if (auto val_opt = osc_listener_handler.getPendingQualityLock()) {
+            for (auto& output : outputs) {
+                output->quality.setLocked(*val_opt);
+            }
+            std::cout << "Main: Applied Quality Lock set to: " << *val_opt << std::endl;
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingQualityQuery()) {
+            quality_subscriber = *val_opt;
+            // Answer the query now
+            std::fill(reported_quality_levels.begin(), reported_quality_levels.end(), QualityGovernor::kLevelCount);
+        }
+        for (std::size_t i = 0; quality_subscriber && i < outputs.size(); ++i) {
+            if (outputs[i]->quality.level() != reported_quality_levels[i]) {
+                reported_quality_levels[i] = outputs[i]->quality.level();
+                if (osc_receiver) {
+                    sendQualityReport(*osc_receiver, *quality_subscriber, *outputs[i]);
+                }
+            }
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingMemoryQuery()) {
+            for (unsigned int i = 0; i < nScopes; ++i) {
+                std::cout << "Memory: Scope " << i << " uses " << (scopes[i].getMemoryUsage() >> 10) << " of "
+                          << (scopes[i].getMemoryQuota() >> 10) << " KB, persistence "
+                          << scopes[i].getPersistenceSamples() << " of " << scopes[i].getMaxPersistenceSamples()
+                          << ", density reserve " << (scopes[i].getDensityMemory() >> 10) << " KB" << std::endl;
+                if (osc_receiver) {
+                    sendMemoryReport(*osc_receiver, *val_opt, i, scopes[i]);
+                }
+            }
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingRenderMode()) {
+            scopes[scope_index].setRenderMode(*val_opt);
+            if (tuning_buffer) {
+                bufferTuner.noteLoadChange(std::chrono::steady_clock::now());
+            }
+            std::cout << "Main: Applied Render Mode set to: " << renderModeName(scopes[scope_index].getRenderMode()) << std::endl;
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingDensityDecay()) {
+            scopes[scope_index].setDensityDecay(*val_opt);
+            std::cout << "Main: Applied Density Decay set to: " << scopes[scope_index].getDensityDecay() << " s" << std::endl;
+        }
 
-        for (unsigned int i=0; i<nScopes; i++) {
+        if (auto val_opt = osc_listener_handler.getPendingDensityGamma()) {
+            scopes[scope_index].setDensityGamma(*val_opt);
+            std::cout << "Main: Applied Density Gamma set to: " << scopes[scope_index].getDensityGamma() << std::endl;
+        }
 
-            traceTexture.clear(sf::Color::Transparent);
-            traceTexture.draw(scopes[i]);
-        
-            traceTexture.display();
+        if (auto val_opt = osc_listener_handler.getPendingTimeBase()) {
+            scopes[scope_index].setTimeBase(*val_opt);
+            std::cout << "Main: Applied Time Base set to: " << scopes[scope_index].getTimeBase() << " s" << std::endl;
+        }
 
-            gaussianBlurShader.setUniform("texture", compositeTexture.getTexture());
-            gaussianBlurShader.setUniform("texture_size", sf::Glsl::Vec2(traceTexture.getSize()));
-            gaussianBlurShader.setUniform("blur_direction", sf::Glsl::Vec2(1.f, 0.f));
-            gaussianBlurShader.setUniform("blur_spread_px", scopes[i].getBlurSpread());
-            
-            blurTexture.clear(sf::Color::Transparent);
-            blurTexture.draw(sf::Sprite(traceTexture.getTexture()), &gaussianBlurShader);
-            blurTexture.display();
+        if (auto val_opt = osc_listener_handler.getPendingTriggerSource()) {
+            scopes[scope_index].setTriggerSource(*val_opt);
+            std::cout << "Main: Applied Trigger Source set to: " << scopes[scope_index].getTriggerSource() << std::endl;
+        }
 
-            gaussianBlurShader.setUniform("texture", blurTexture.getTexture());
-            gaussianBlurShader.setUniform("blur_direction", sf::Glsl::Vec2(0.f, 1.f));
+        if (auto val_opt = osc_listener_handler.getPendingTriggerEdge()) {
+            scopes[scope_index].setTriggerEdge(*val_opt);
+            std::cout << "Main: Applied Trigger Edge set to: " << triggerEdgeName(scopes[scope_index].getTriggerEdge()) << std::endl;
+        }
 
-            frameTexture.clear(sf::Color::Transparent);
-            frameTexture.draw(sf::Sprite(blurTexture.getTexture()), &gaussianBlurShader);
-            frameTexture.display();
+        if (auto val_opt = osc_listener_handler.getPendingTriggerLevel()) {
+            scopes[scope_index].setTriggerLevel(*val_opt);
+            std::cout << "Main: Applied Trigger Level set to: " << scopes[scope_index].getTriggerLevel() << std::endl;
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingTriggerHysteresis()) {
+            scopes[scope_index].setTriggerHysteresis(*val_opt);
+            std::cout << "Main: Applied Trigger Hysteresis set to: " << scopes[scope_index].getTriggerHysteresis() << std::endl;
+        }
 
-            window.draw(sf::Sprite(frameTexture.getTexture()));
+        if (auto val_opt = osc_listener_handler.getPendingTriggerMode()) {
+            scopes[scope_index].setTriggerMode(*val_opt);
+            std::cout << "Main: Applied Trigger Mode set to: " << triggerModeName(scopes[scope_index].getTriggerMode()) << std::endl;
         }
-        window.display();
+
+        if (auto val_opt = osc_listener_handler.getPendingHoldoff()) {
+            scopes[scope_index].setHoldoff(*val_opt);
+            std::cout << "Main: Applied Holdoff set to: " << scopes[scope_index].getHoldoff() << " s" << std::endl;
+        }
+
+        if (auto val_opt = osc_listener_handler.getPendingSweepCount()) {
+            scopes[scope_index].setSweepCount(*val_opt);
+            std::cout << "Main: Applied Sweep Count set to: " << scopes[scope_index].getSweepCount() << std::endl;
+        }
+    }
+
+    stop_replay = true;
+    if (replay_thread.joinable()) {
+        replay_thread.join();
+    }
+
+    for (auto& output : outputs) {
+        output->state.running = false;
+    }
+    const double render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - render_start).count();
+    for (auto& output : outputs) {
+        if (output->thread.joinable()) {
+            output->thread.join();
+        }
+        if (output->window) {
+            output->window->close();
+        }
+        const std::uint64_t frames = output->state.frames.load();
+        std::cout << "Output " << output->index << " (" << (output->window ? "window " : "offscreen ")
+                  << output->spec.width << "x" << output->spec.height << "): " << frames << " frames, "
+                  << frames / render_seconds << " fps" << std::endl;
     }
 
     std::cout << "Stopping OSC receiver and Asio context..." << std::endl;
@@ -281,10 +1101,33 @@ int main() {
         asio_thread.join();
     }
 
-    if (audio.isStreamOpen()) {
-        audio.stopStream();
-        audio.closeStream();
+    if (udp_input) {
+        udp_input->stop();
+    }
+    if (device_input && device_input->audio->isStreamOpen()) {
+        if (device_input->audio->isStreamRunning()) {
+            device_input->audio->stopStream();
+        }
+        device_input->audio->closeStream();
+    }
+    if (tuning_buffer) {
+        printBufferReport(bufferTuner);
+    }
+    // Master first, so it stops pulling before the slaves stop pushing
+    for (auto& stream : aggregated_inputs) {
+        RtAudio& input = *stream->input.audio;
+        if (input.isStreamOpen()) {
+            if (input.isStreamRunning()) {
+                input.stopStream();
+            }
+            input.closeStream();
+        }
+    }
+    if (aggregator) {
+        printAggregatorStats(*aggregator);
     }
+    recorder.stop();
+    rtcheck::printSummary();
     
     std::cout << "Application finished." << std::endl;
     
@@ -1,11 +1,13 @@
 #include "include/osc.hpp"
 #include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
 
 OSCListener::OSCListener() = default;
 OSCListener::~OSCListener() = default;
 
 void OSCListener::ProcessMessage(const osc::ReceivedMessage& m, const IpEndpointName& remoteEndpoint) {
-    (void) remoteEndpoint; // Mark as unused if not needed
     try {
         // For debugging, you can keep this:
         // std::cout << "OSC Message Received: " << m.AddressPattern() << std::endl;
@@ -93,10 +95,120 @@ void OSCListener::ProcessMessage(const osc::ReceivedMessage& m, const IpEndpoint
                     } else {
                         std::cerr << "  OSC: Scale received: " << val << std::endl;
                     }
+                } else if (std::strcmp(param_pattern, "/mode") == 0) {
+                    const char* val; // OSC 's' type tag: "trace", "density" or "yt"
+                    args >> val >> osc::EndMessage;
+                    if (auto mode = parseRenderMode(val)) {
+                        render_mode_update_ = *mode;
+                        std::cout << "  OSC: Render mode update queued: " << val << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid render mode received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/density/decay") == 0) {
+                    float val; // Seconds
+                    args >> val >> osc::EndMessage;
+                    if (val > 0.0f) {
+                        density_decay_update_ = val;
+                        std::cout << "  OSC: Density decay update queued: " << *density_decay_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid density decay received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/density/gamma") == 0) {
+                    float val;
+                    args >> val >> osc::EndMessage;
+                    if (val > 0.0f) {
+                        density_gamma_update_ = val;
+                        std::cout << "  OSC: Density gamma update queued: " << *density_gamma_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid density gamma received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/timebase") == 0) {
+                    float val; // Seconds per sweep
+                    args >> val >> osc::EndMessage;
+                    if (val > 0.0f) {
+                        time_base_update_ = val;
+                        std::cout << "  OSC: Time base update queued: " << *time_base_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid time base received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/trigger/source") == 0) {
+                    osc::int32 val; // 0 = x channel, 1 = y channel
+                    args >> val >> osc::EndMessage;
+                    if (val == 0 || val == 1) {
+                        trigger_source_update_ = static_cast<unsigned int>(val);
+                        std::cout << "  OSC: Trigger source update queued: " << *trigger_source_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid trigger source (0-1) received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/trigger/edge") == 0) {
+                    const char* val; // "rising" or "falling"
+                    args >> val >> osc::EndMessage;
+                    if (auto edge = parseTriggerEdge(val)) {
+                        trigger_edge_update_ = *edge;
+                        std::cout << "  OSC: Trigger edge update queued: " << val << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid trigger edge received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/trigger/level") == 0) {
+                    float val; // Full scale units
+                    args >> val >> osc::EndMessage;
+                    if (val >= -1.0f && val <= 1.0f) {
+                        trigger_level_update_ = val;
+                        std::cout << "  OSC: Trigger level update queued: " << *trigger_level_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid trigger level (-1 to 1) received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/trigger/hysteresis") == 0) {
+                    float val;
+                    args >> val >> osc::EndMessage;
+                    if (val >= 0.0f) {
+                        trigger_hysteresis_update_ = val;
+                        std::cout << "  OSC: Trigger hysteresis update queued: " << *trigger_hysteresis_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid trigger hysteresis received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/trigger/mode") == 0) {
+                    const char* val; // "auto" or "normal"
+                    args >> val >> osc::EndMessage;
+                    if (auto mode = parseTriggerMode(val)) {
+                        trigger_mode_update_ = *mode;
+                        std::cout << "  OSC: Trigger mode update queued: " << val << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid trigger mode received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/holdoff") == 0) {
+                    float val; // Seconds
+                    args >> val >> osc::EndMessage;
+                    if (val >= 0.0f) {
+                        holdoff_update_ = val;
+                        std::cout << "  OSC: Holdoff update queued: " << *holdoff_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid holdoff received: " << val << std::endl;
+                    }
+                } else if (std::strcmp(param_pattern, "/yt/sweeps") == 0) {
+                    osc::int32 val;
+                    args >> val >> osc::EndMessage;
+                    if (val >= 1 && val <= static_cast<osc::int32>(SweepCapture::kMaxSweeps)) {
+                        sweep_count_update_ = static_cast<unsigned int>(val);
+                        std::cout << "  OSC: Sweep count update queued: " << *sweep_count_update_ << std::endl;
+                    } else {
+                        std::cerr << "  OSC: Invalid sweep count (1-" << SweepCapture::kMaxSweeps << ") received: " << val << std::endl;
+                    }
                 }
             } else {
                 std::cerr << "  OSC: Invalid scope index received: " << scope_index << std::endl;
             }
+        } else if (std::strcmp(m.AddressPattern(), "/quality") == 0) {
+            args >> osc::EndMessage;
+            quality_query_from_ = remoteEndpoint;
+        } else if (std::strcmp(m.AddressPattern(), "/quality/lock") == 0) {
+            osc::int32 val; // 1 pins full quality, 0 returns control to the governor
+            args >> val >> osc::EndMessage;
+            quality_lock_update_ = val != 0;
+            std::cout << "  OSC: Quality lock update queued: " << *quality_lock_update_ << std::endl;
+        } else if (std::strcmp(m.AddressPattern(), "/memory") == 0) {
+            args >> osc::EndMessage;
+            memory_query_from_ = remoteEndpoint;
         }
 
     } catch(const osc::Exception& e) {
@@ -156,6 +268,104 @@ std::optional<float> OSCListener::getPendingScale() {
     return val;
 }
 
+std::optional<RenderMode> OSCListener::getPendingRenderMode() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<RenderMode> val = render_mode_update_;
+    render_mode_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingDensityDecay() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = density_decay_update_;
+    density_decay_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingDensityGamma() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = density_gamma_update_;
+    density_gamma_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingTimeBase() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = time_base_update_;
+    time_base_update_.reset();
+    return val;
+}
+
+std::optional<unsigned int> OSCListener::getPendingTriggerSource() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<unsigned int> val = trigger_source_update_;
+    trigger_source_update_.reset();
+    return val;
+}
+
+std::optional<TriggerEdge> OSCListener::getPendingTriggerEdge() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<TriggerEdge> val = trigger_edge_update_;
+    trigger_edge_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingTriggerLevel() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = trigger_level_update_;
+    trigger_level_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingTriggerHysteresis() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = trigger_hysteresis_update_;
+    trigger_hysteresis_update_.reset();
+    return val;
+}
+
+std::optional<TriggerMode> OSCListener::getPendingTriggerMode() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<TriggerMode> val = trigger_mode_update_;
+    trigger_mode_update_.reset();
+    return val;
+}
+
+std::optional<float> OSCListener::getPendingHoldoff() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<float> val = holdoff_update_;
+    holdoff_update_.reset();
+    return val;
+}
+
+std::optional<unsigned int> OSCListener::getPendingSweepCount() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<unsigned int> val = sweep_count_update_;
+    sweep_count_update_.reset();
+    return val;
+}
+
+std::optional<bool> OSCListener::getPendingQualityLock() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<bool> val = quality_lock_update_;
+    quality_lock_update_.reset();
+    return val;
+}
+
+std::optional<IpEndpointName> OSCListener::getPendingQualityQuery() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<IpEndpointName> val = quality_query_from_;
+    quality_query_from_.reset();
+    return val;
+}
+
+std::optional<IpEndpointName> OSCListener::getPendingMemoryQuery() {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    std::optional<IpEndpointName> val = memory_query_from_;
+    memory_query_from_.reset();
+    return val;
+}
+
 int::OSCListener::getIndex() const {
     return rcv_index;
 }
@@ -205,6 +415,27 @@ void AsioOscReceiver::stop() {
     }
 }
 
+void AsioOscReceiver::setPacketObserver(std::function<void(const char*, std::size_t)> observer) {
+    packet_observer_ = std::move(observer);
+}
+
+void AsioOscReceiver::send(const IpEndpointName& destination, const char* data, std::size_t size) {
+    // The socket belongs to the io_context thread; hand it a copy of the packet
+    auto packet = std::make_shared<std::vector<char>>(data, data + size);
+    asio::ip::udp::endpoint endpoint(asio::ip::address_v4(static_cast<asio::ip::address_v4::uint_type>(destination.address)),
+                                     static_cast<unsigned short>(destination.port));
+    asio::post(socket_.get_executor(), [this, packet, endpoint]() {
+        if (stopped_ || !socket_.is_open()) {
+            return;
+        }
+        asio::error_code ec;
+        socket_.send_to(asio::buffer(*packet), endpoint, 0, ec);
+        if (ec) {
+            std::cerr << "Failed to send OSC reply: " << ec.message() << std::endl;
+        }
+    });
+}
+
 void AsioOscReceiver::startReceive() {
     if (stopped_ || !socket_.is_open()) {
         return;
@@ -231,6 +462,10 @@ void AsioOscReceiver::handleReceive(const asio::error_code& error, std::size_t b
             remote_endpoint_asio_.port()                         // Get port
         );
 
+        if (packet_observer_) {
+            packet_observer_(recv_buffer_.data(), bytes_recvd);
+        }
+
         try {
             // Pass the raw data to OSCListener (which derives from osc::OscPacketListener)
             listener_.ProcessPacket(recv_buffer_.data(), static_cast<int>(bytes_recvd), oscpack_remote_endpoint);
@@ -1,4 +1,7 @@
 #include "include/oscilloscope.hpp"
+#include "include/density_histogram.hpp"
+
+#include <utility>
 
 sf::Vector2f normalize(const sf::Vector2f& source) {
     float length = std::hypot(source.x, source.y);
@@ -21,17 +24,164 @@ float distance(float x1, float y1, float x2, float y2) {
     return std::hypot(x1 - x2, y1 - y2);
 }
 
-Oscilloscope::Oscilloscope() : m_has_valid_last_point(false), m_thickness(1.f) {
-    prev_vertex.position = {0.f, 0.f};
-    prev_vertex.color = sf::Color::Transparent;
-} 
+namespace {
+
+// Density points buffered between frames, per output; several seconds of audio,
+// so a stalled render thread drops samples long before the audio thread would care
+constexpr std::size_t kDensityPointCapacity = 1 << 17;
+
+// Strip vertices of a full Y-T view: for each sweep and channel, two points per
+// column with two vertices each, plus two to bridge from the previous strip
+constexpr std::size_t kSweepVertices = SweepCapture::kMaxSweeps * 2 * (4 * SweepCapture::kColumns + 2);
+
+// Geometry slot capacity: two strip vertices per history point, or a full Y-T view
+std::size_t stripCapacity(std::size_t historyPoints) {
+    return std::max(2 * historyPoints, kSweepVertices);
+}
+
+// Appends a polyline of the given half width to a triangle strip, joined to
+// what is already there by two degenerate triangles
+bool appendPolyline(std::vector<sf::Vertex>& strip, const sf::Vector2f* points, std::size_t count,
+                    float halfWidth, sf::Color color) {
+    if (count < 2 || strip.size() + 2 * count + 2 > strip.capacity()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        const sf::Vector2f tangent = normalize(points[std::min(i + 1, count - 1)] - points[i > 0 ? i - 1 : 0]);
+        sf::Vector2f normal_vec = perpendicular(tangent);
+        if (distance(normal_vec, {0.f, 0.f}) < 0.0001f) {
+            normal_vec = sf::Vector2f(0.f, 1.f);
+        }
+        const sf::Vertex upper(points[i] + normal_vec * halfWidth, color);
+        if (i == 0 && !strip.empty()) {
+            const sf::Vertex bridge = strip.back();
+            strip.push_back(bridge);
+            strip.push_back(upper);
+        }
+        strip.push_back(upper);
+        strip.push_back(sf::Vertex(points[i] - normal_vec * halfWidth, color));
+    }
+    return true;
+}
+
+} // namespace
+
+Oscilloscope::TraceHistory::TraceHistory(std::size_t chunks)
+    : table(std::make_unique<Chunk[]>(kMaxChunks)),
+      chunkCount(std::clamp<std::size_t>(chunks, 1, kMaxChunks)),
+      capacity(chunkCount * kChunkPoints) {
+    for (std::size_t i = 0; i < chunkCount; ++i) {
+        table[i] = std::make_unique<Point[]>(kChunkPoints);
+    }
+}
+
+void Oscilloscope::TraceHistory::push(const Point& point) {
+    table[head / kChunkPoints][head % kChunkPoints] = point;
+    head = head + 1 == capacity ? 0 : head + 1;
+    count = std::min(count + 1, capacity);
+}
+
+const Oscilloscope::TraceHistory::Point& Oscilloscope::TraceHistory::operator[](std::size_t i) const {
+    const std::size_t position = (head + capacity - 1 - i) % capacity;
+    return table[position / kChunkPoints][position % kChunkPoints];
+}
+
+void Oscilloscope::TraceHistory::rotateHeadToFront() {
+    // Only the order of the chunks matters, so every point keeps its place in the ring
+    const std::size_t first = head / kChunkPoints;
+    std::rotate(table.get(), table.get() + first, table.get() + chunkCount);
+    head -= first * kChunkPoints;
+}
+
+void Oscilloscope::TraceHistory::grow(std::vector<Chunk>& added) {
+    const std::size_t n = std::min(added.size(), kMaxChunks - chunkCount);
+    if (n == 0) {
+        return;
+    }
+    rotateHeadToFront();
+    // The head is the next write slot, so it holds the oldest point and points
+    // get newer going forward from it. The new chunks go right after the head's
+    // chunk, and the oldest points, from the head to the end of that chunk,
+    // move to the same place in the last new chunk; the gap opens at the head
+    const std::size_t at = head == 0 ? 0 : 1;
+    std::move_backward(table.get() + at, table.get() + chunkCount, table.get() + chunkCount + n);
+    for (std::size_t i = 0; i < n; ++i) {
+        table[at + i] = std::move(added[i]);
+    }
+    if (head != 0) {
+        std::copy(table[0].get() + head, table[0].get() + kChunkPoints, table[n].get() + head);
+    }
+    chunkCount += n;
+    capacity = chunkCount * kChunkPoints;
+}
+
+void Oscilloscope::TraceHistory::shrink(std::size_t chunks, std::vector<Chunk>& removed) {
+    const std::size_t n = std::min(chunkCount - std::min(std::max<std::size_t>(chunks, 1), chunkCount),
+                                   removed.capacity() - removed.size());
+    if (n == 0) {
+        return;
+    }
+    rotateHeadToFront();
+    // Drop the oldest chunks after the head's own; the points behind the head
+    // in the last dropped chunk move into the head's chunk, so no gap remains
+    const std::size_t from = head == 0 ? 0 : 1;
+    if (head != 0) {
+        std::copy(table[n].get() + head, table[n].get() + kChunkPoints, table[0].get() + head);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        removed.push_back(std::move(table[from + i]));
+    }
+    std::move(table.get() + from + n, table.get() + chunkCount, table.get() + from);
+    chunkCount -= n;
+    capacity = chunkCount * kChunkPoints;
+    count = std::min(count, capacity);
+}
+
+Oscilloscope::Oscilloscope()
+    : m_has_valid_last_point(false), m_history(historyChunksFor(kDefaultPersistenceSamples)) {
+    m_historyChunks = m_history.chunkCount;
+    m_wantedChunks = m_history.chunkCount;
+    m_allocatedChunks = m_history.chunkCount;
+    // Preallocated, so processSamples never has to grow a slot
+    const std::size_t vertices = stripCapacity(m_history.capacity);
+    m_geometry.forEachSlot([this, vertices](ScopeGeometry& geometry) {
+        geometry.strip.reserve(vertices);
+        m_geometryBytes += geometry.strip.capacity() * sizeof(sf::Vertex);
+    });
+}
+
+Oscilloscope::~Oscilloscope() {
+    delete m_pendingResize.exchange(nullptr);
+    delete m_retiredResize.exchange(nullptr);
+}
+
+std::size_t Oscilloscope::historyChunksFor(unsigned int samples) {
+    const std::size_t chunks = (static_cast<std::size_t>(samples) + TraceHistory::kChunkPoints - 1) / TraceHistory::kChunkPoints;
+    return std::clamp<std::size_t>(chunks, 1, TraceHistory::kMaxChunks);
+}
 
 void Oscilloscope::updateView(const sf::Vector2u& newSize) {
-    m_center.x = static_cast<float>(newSize.x) / 2.f;
-    m_center.y = static_cast<float>(newSize.y) / 2.f;
+    m_center_x = static_cast<float>(newSize.x) / 2.f;
+    m_center_y = static_cast<float>(newSize.y) / 2.f;
     m_radius = std::min(static_cast<float>(newSize.x), static_cast<float>(newSize.y)) / 2.0f;
 }
 
+sf::Vector2f Oscilloscope::getViewCenter() const {
+    return {m_center_x.load(), m_center_y.load()};
+}
+
+float Oscilloscope::getViewRadius() const {
+    return m_radius;
+}
+
+void Oscilloscope::attachOutput(std::size_t output) {
+    // Counted against the memory quota; attach outputs before setting it
+    if (!m_densityPoints[output]) {
+        m_densityPoints[output] = std::make_unique<FrameRing>(kDensityPointCapacity, 2);
+    }
+    m_geometryBuildTakenNs[output] = m_geometryBuildNs.load(std::memory_order_relaxed);
+}
+
 void Oscilloscope::setTraceThickness(float thickness) {
     m_thickness = std::max(thickness, 1.f);;
 }
@@ -41,17 +191,130 @@ float Oscilloscope::getTraceThickness() const {
 }
 
 void Oscilloscope::setTraceColor(sf::Color c) {
-    trace_color = c;
+    trace_color = c.toInteger();
 }
 
 sf::Color Oscilloscope::getTraceColor() const {
-    return trace_color;
+    return sf::Color(trace_color.load());
 }
 
 void Oscilloscope::setPersistenceSamples(unsigned int n) {
-    maxPersistentSamples = n;
-    alpha_values.resize(n);
-    center_line_points.resize(n);
+    maxPersistentSamples = std::min(n, getMaxPersistenceSamples());
+    m_wantedChunks = historyChunksFor(maxPersistentSamples);
+    queueHistoryResize();
+}
+
+void Oscilloscope::setMemoryQuota(std::size_t bytes) {
+    m_memoryQuota = bytes;
+    if (maxPersistentSamples > getMaxPersistenceSamples()) {
+        setPersistenceSamples(maxPersistentSamples);
+    }
+}
+
+std::size_t Oscilloscope::getMemoryQuota() const {
+    return m_memoryQuota;
+}
+
+std::size_t Oscilloscope::getDensityMemory() const {
+    std::size_t bytes = 0;
+    for (const auto& points : m_densityPoints) {
+        if (points) {
+            // The renderer caps its histogram at a fixed size, so it is reserved whether or not it is in use
+            bytes += points->capacity() * points->channels() * sizeof(float) +
+                     DensityHistogram::maxBytes(points->capacity());
+        }
+    }
+    return bytes;
+}
+
+std::size_t Oscilloscope::memoryFor(unsigned int samples) const {
+    // Every geometry slot at full length, plus the old buffer of the one being regrown
+    const std::size_t chunks = historyChunksFor(samples);
+    const std::size_t geometry = (m_geometry.slotCount() + 1) * stripCapacity(chunks * TraceHistory::kChunkPoints);
+    return sizeof(Oscilloscope) + TraceHistory::kMaxChunks * sizeof(TraceHistory::Chunk) + getDensityMemory() +
+           chunks * TraceHistory::kChunkPoints * sizeof(TraceHistory::Point) + geometry * sizeof(sf::Vertex);
+}
+
+unsigned int Oscilloscope::getMaxPersistenceSamples() const {
+    // Most whole chunks that fit, but never less than one
+    std::size_t low = 1;
+    std::size_t high = TraceHistory::kMaxChunks;
+    while (low < high) {
+        const std::size_t mid = (low + high + 1) / 2;
+        if (memoryFor(static_cast<unsigned int>(mid * TraceHistory::kChunkPoints)) <= m_memoryQuota) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return static_cast<unsigned int>(low * TraceHistory::kChunkPoints);
+}
+
+std::size_t Oscilloscope::getMemoryUsage() const {
+    return sizeof(Oscilloscope) + TraceHistory::kMaxChunks * sizeof(TraceHistory::Chunk) + getDensityMemory() +
+           m_allocatedChunks * TraceHistory::kChunkPoints * sizeof(TraceHistory::Point) + m_geometryBytes;
+}
+
+void Oscilloscope::freeResize(HistoryResize* resize) {
+    if (resize) {
+        m_allocatedChunks -= static_cast<std::size_t>(std::count_if(
+            resize->spare.begin(), resize->spare.end(), [](const TraceHistory::Chunk& chunk) { return chunk != nullptr; }));
+        delete resize;
+    }
+}
+
+void Oscilloscope::queueHistoryResize() {
+    // Take back a queued resize the audio thread has not picked up if it is out of date
+    const HistoryResize* queued = m_pendingResize.load(std::memory_order_acquire);
+    if (queued && queued->chunks == m_wantedChunks) {
+        return;
+    }
+    if (queued) {
+        if (HistoryResize* unclaimed = m_pendingResize.exchange(nullptr, std::memory_order_acq_rel)) {
+            m_historyChunks = unclaimed->chunksBefore;
+            freeResize(unclaimed);
+        }
+    }
+
+    // One resize at a time, so chunks given back are freed before more are allocated
+    if (m_retiredResize.load(std::memory_order_acquire) || m_pendingResize.load(std::memory_order_acquire) ||
+        m_wantedChunks == m_historyChunks) {
+        return;
+    }
+    auto resize = std::make_unique<HistoryResize>();
+    resize->chunksBefore = m_historyChunks;
+    resize->chunks = m_wantedChunks;
+    if (m_wantedChunks > m_historyChunks) {
+        resize->spare.reserve(m_wantedChunks - m_historyChunks);
+        for (std::size_t i = m_historyChunks; i < m_wantedChunks; ++i) {
+            resize->spare.push_back(std::make_unique<TraceHistory::Point[]>(TraceHistory::kChunkPoints));
+        }
+        m_allocatedChunks += m_wantedChunks - m_historyChunks;
+    } else {
+        resize->spare.reserve(m_historyChunks - m_wantedChunks);
+    }
+    m_historyChunks = m_wantedChunks;
+    m_pendingResize.store(resize.release(), std::memory_order_release);
+}
+
+void Oscilloscope::releaseRetiredBuffers() {
+    freeResize(m_retiredResize.exchange(nullptr, std::memory_order_acq_rel));
+    queueHistoryResize();
+
+    // Snapshots cycle through every slot, so the audio thread sees the new
+    // capacity a few blocks after the trace length changes
+    const std::size_t vertices = stripCapacity(m_wantedChunks * TraceHistory::kChunkPoints);
+    m_geometry.forEachIdleSlot([this, vertices](ScopeGeometry& geometry) {
+        const std::size_t before = geometry.strip.capacity();
+        if (before < vertices) {
+            geometry.strip.reserve(vertices);
+        } else if (before > vertices) {
+            std::vector<sf::Vertex> smaller;
+            smaller.reserve(vertices);
+            geometry.strip.swap(smaller);
+        }
+        m_geometryBytes = m_geometryBytes - before * sizeof(sf::Vertex) + geometry.strip.capacity() * sizeof(sf::Vertex);
+    });
 }
 
 unsigned int Oscilloscope::getPersistenceSamples() const {
@@ -90,83 +353,315 @@ unsigned int Oscilloscope::getAlphaScale() const {
     return alpha_scale;
 }
 
+void Oscilloscope::setRenderMode(RenderMode mode) {
+    m_renderMode = mode;
+}
+
+RenderMode Oscilloscope::getRenderMode() const {
+    return m_renderMode;
+}
+
+void Oscilloscope::setDensityDecay(float seconds) {
+    m_densityDecay = std::max(seconds, 0.001f);
+}
+
+float Oscilloscope::getDensityDecay() const {
+    return m_densityDecay;
+}
+
+void Oscilloscope::setDensityGamma(float gamma) {
+    m_densityGamma = std::max(gamma, 0.01f);
+}
+
+float Oscilloscope::getDensityGamma() const {
+    return m_densityGamma;
+}
+
+void Oscilloscope::setSampleRate(unsigned int rate) {
+    m_sampleRate = std::max(rate, 1u);
+}
+
+unsigned int Oscilloscope::getSampleRate() const {
+    return m_sampleRate;
+}
+
+void Oscilloscope::setTimeBase(float seconds) {
+    m_timeBase = std::max(seconds, 0.0001f);
+}
+
+float Oscilloscope::getTimeBase() const {
+    return m_timeBase;
+}
+
+void Oscilloscope::setTriggerSource(unsigned int channel) {
+    m_triggerSource = std::min(channel, 1u);
+}
+
+unsigned int Oscilloscope::getTriggerSource() const {
+    return m_triggerSource;
+}
+
+void Oscilloscope::setTriggerEdge(TriggerEdge edge) {
+    m_triggerEdge = edge;
+}
+
+TriggerEdge Oscilloscope::getTriggerEdge() const {
+    return m_triggerEdge;
+}
+
+void Oscilloscope::setTriggerLevel(float level) {
+    m_triggerLevel = std::clamp(level, -1.f, 1.f);
+}
+
+float Oscilloscope::getTriggerLevel() const {
+    return m_triggerLevel;
+}
+
+void Oscilloscope::setTriggerHysteresis(float hysteresis) {
+    m_triggerHysteresis = std::clamp(hysteresis, 0.f, 2.f);
+}
+
+float Oscilloscope::getTriggerHysteresis() const {
+    return m_triggerHysteresis;
+}
+
+void Oscilloscope::setTriggerMode(TriggerMode mode) {
+    m_triggerMode = mode;
+}
+
+TriggerMode Oscilloscope::getTriggerMode() const {
+    return m_triggerMode;
+}
+
+void Oscilloscope::setHoldoff(float seconds) {
+    m_holdoff = std::max(seconds, 0.f);
+}
+
+float Oscilloscope::getHoldoff() const {
+    return m_holdoff;
+}
+
+void Oscilloscope::setSweepCount(unsigned int n) {
+    m_sweepCount = std::clamp<unsigned int>(n, 1, SweepCapture::kMaxSweeps);
+}
+
+unsigned int Oscilloscope::getSweepCount() const {
+    return m_sweepCount;
+}
+
+FrameRing& Oscilloscope::densityPoints(std::size_t output) {
+    return *m_densityPoints[output];
+}
+
+void Oscilloscope::setPointStride(std::size_t output, unsigned int stride) {
+    m_pointStrides[output] = stride;
+}
+
+unsigned int Oscilloscope::getPointStride() const {
+    unsigned int stride = 1;
+    for (const auto& requested : m_pointStrides) {
+        stride = std::max(stride, requested.load(std::memory_order_relaxed));
+    }
+    return stride;
+}
+
+std::chrono::nanoseconds Oscilloscope::takeGeometryBuildTime(std::size_t output) {
+    const std::int64_t total = m_geometryBuildNs.load(std::memory_order_relaxed);
+    const std::int64_t taken = std::exchange(m_geometryBuildTakenNs[output], total);
+    return std::chrono::nanoseconds(total - taken);
+}
+
+
+bool Oscilloscope::acquireGeometry(std::size_t output) {
+    return m_geometry.acquire(output);
+}
+
+const ScopeGeometry& Oscilloscope::geometry(std::size_t output) const {
+    return m_geometry.front(output);
+}
+
+void Oscilloscope::adoptPendingHistory() {
+    // Resize the history, but only once the previous resize has been freed
+    if (m_retiredResize.load(std::memory_order_acquire) == nullptr) {
+        if (HistoryResize* resize = m_pendingResize.exchange(nullptr, std::memory_order_acq_rel)) {
+            if (resize->chunks > m_history.chunkCount) {
+                m_history.grow(resize->spare);
+            } else {
+                m_history.shrink(resize->chunks, resize->spare);
+            }
+            m_retiredResize.store(resize, std::memory_order_release);
+        }
+    }
+}
+
+template <typename Sample, std::size_t Stride>
+void Oscilloscope::processSamples(const Sample* frames, std::size_t frameCount, std::size_t frameStride,
+                                  std::chrono::steady_clock::time_point captureTime) {
+    adoptPendingHistory();
+
+    // A fixed stride lets the compiler turn the frame walk into constant offsets
+    const std::size_t stride = Stride != 0 ? Stride : frameStride;
+    const sf::Vector2f center(m_center_x.load(), m_center_y.load());
+    const float radius = m_radius.load();
+    const float traceScale = scale.load();
+    const float alphaScale = static_cast<float>(alpha_scale.load());
+    const sf::Color color(trace_color.load());
+    const RenderMode mode = m_renderMode.load(std::memory_order_relaxed);
+    const bool density = mode == RenderMode::Density;
+
+    if (mode == RenderMode::TimeDomain) {
+        captureSweeps<Sample, Stride>(frames, frameCount, stride);
+        m_lastMode = mode;
+        // The XY trace restarts from the next sample instead of drawing a jump
+        m_has_valid_last_point = false;
+        publishGeometry(captureTime);
+        return;
+    }
+    m_lastMode = mode;
 
-void Oscilloscope::processSamples(const std::int16_t* samples, std::size_t sampleCount) {
-    std::lock_guard<std::mutex> lock(m_mutex);
     sf::Vector2f prev_xy;
     if (m_has_valid_last_point) {
-        prev_xy = prev_vertex.position;
-    } else if (sampleCount > 0) {
-        float x_sample0 = static_cast<float>(samples[0]) / 32768.f;
-        float y_sample0 = (sampleCount > 1) ? static_cast<float>(samples[1]) / 32768.f : 0.f;
-        prev_xy = {m_center.x + x_sample0 * m_radius * scale,
-                                          m_center.y + y_sample0 * m_radius * scale};
+        prev_xy = prev_position;
+    } else if (frameCount > 0) {
+        float x_sample0 = sampleToUnit(frames[0]);
+        float y_sample0 = sampleToUnit(frames[1]);
+        prev_xy = {center.x + x_sample0 * radius * traceScale,
+                   center.y + y_sample0 * radius * traceScale};
     } else {
-        m_triangle_strip.clear();
+        publishGeometry(captureTime);
         return;
     }
-    for (std::size_t i = 0; i < sampleCount; i += 2) {
-        float x_sample = static_cast<float>(samples[i]) / 32768.f;
-        float y_sample = 0.f;
-        if (i + 1 < sampleCount) {
-            y_sample = static_cast<float>(samples[i + 1]) / 32768.f;
-        }
 
-        sf::Vector2f current_screen_pos(m_center.x + x_sample * m_radius * scale,
-                                        m_center.y - y_sample * m_radius * scale);
+    TraceHistory& history = m_history;
+    for (std::size_t j = 0; j < frameCount; ++j) {
+        float x_sample = sampleToUnit(frames[j * stride]);
+        float y_sample = sampleToUnit(frames[j * stride + 1]);
 
-        float sample_dist = distance(prev_xy, current_screen_pos)/(m_radius*scale);
-        uint8_t alpha = static_cast<uint8_t>(255.f - std::min(sample_dist * alpha_scale, 255.f));
+        sf::Vector2f current_screen_pos(center.x + x_sample * radius * traceScale,
+                                        center.y - y_sample * radius * traceScale);
 
-        center_line_points.push_front(sf::Vertex(current_screen_pos,sf::Color(trace_color.r, trace_color.g, trace_color.b, alpha)));
-        alpha_values.push_front(alpha);
+        float sample_dist = distance(prev_xy, current_screen_pos)/(radius*traceScale);
+        uint8_t alpha = static_cast<uint8_t>(255.f - std::min(sample_dist * alphaScale, 255.f));
 
-        if (center_line_points.size() > maxPersistentSamples) {
-            center_line_points.pop_back();
-            alpha_values.pop_back();
-        }
+        history.push({current_screen_pos, sf::Color(color.r, color.g, color.b, alpha)});
         prev_xy = current_screen_pos;
+
+        if (density) {
+            for (const auto& points : m_densityPoints) {
+                if (!points) {
+                    continue;
+                }
+                if (float* point = points->beginPush()) {
+                    point[0] = current_screen_pos.x;
+                    point[1] = current_screen_pos.y;
+                }
+            }
+        }
+    }
+    if (density) {
+        for (const auto& points : m_densityPoints) {
+            if (points) {
+                points->commitPush();
+            }
+        }
     }
 
-    if (!center_line_points.empty()) {
-        prev_vertex = center_line_points.front();
+    if (history.count > 0) {
+        prev_position = history[0].position;
         m_has_valid_last_point = true;
     } else {
         m_has_valid_last_point = false;
     }
+    publishGeometry(captureTime);
+}
+
+template <typename Sample, std::size_t Stride>
+void Oscilloscope::captureSweeps(const Sample* frames, std::size_t frameCount, std::size_t frameStride) {
+    const std::size_t stride = Stride != 0 ? Stride : frameStride;
+    if (m_lastMode != RenderMode::TimeDomain) {
+        m_sweeps.reset();
+    }
+
+    const SweepCapture::Settings settings = sweepSettings();
+    float* x = m_sweeps.input(0);
+    float* y = m_sweeps.input(1);
+    for (std::size_t start = 0; start < frameCount; start += SweepCapture::kChunkFrames) {
+        const std::size_t n = std::min(frameCount - start, SweepCapture::kChunkFrames);
+        const Sample* chunk = frames + start * stride;
+        for (std::size_t j = 0; j < n; ++j) {
+            x[j] = sampleToUnit(chunk[j * stride]);
+            y[j] = sampleToUnit(chunk[j * stride + 1]);
+        }
+        m_sweeps.process(n, settings);
+    }
+}
+
+SweepCapture::Settings Oscilloscope::sweepSettings() const {
+    const double rate = m_sampleRate.load();
+    auto toFrames = [rate](double seconds) { return static_cast<std::size_t>(std::llround(seconds * rate)); };
+
+    SweepCapture::Settings settings;
+    settings.source = m_triggerSource.load();
+    settings.edge = m_triggerEdge.load();
+    settings.mode = m_triggerMode.load();
+    settings.level = m_triggerLevel.load();
+    settings.hysteresis = m_triggerHysteresis.load();
+    settings.sweepFrames = std::clamp<std::size_t>(toFrames(m_timeBase.load()), 2, SweepCapture::kMaxSweepFrames);
+    settings.holdoffFrames = toFrames(m_holdoff.load());
+    // Auto mode waits a tenth of a second, or one sweep if that is longer, before free-running
+    settings.autoFrames = std::max(settings.sweepFrames, toFrames(0.1));
+    return settings;
+}
 
-    m_triangle_strip.clear();
-    m_triangle_strip.setPrimitiveType(sf::PrimitiveType::TriangleStrip);
+void Oscilloscope::publishGeometry(std::chrono::steady_clock::time_point captureTime) {
+    const auto buildStart = std::chrono::steady_clock::now();
+    buildGeometry(captureTime);
+    m_geometry.publish();
+    m_geometryBuildNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - buildStart).count(), std::memory_order_relaxed);
+}
 
-    if (center_line_points.size() < 2) {
+void Oscilloscope::buildGeometry(std::chrono::steady_clock::time_point captureTime) {
+    const TraceHistory& history = m_history;
+    const float thickness = m_thickness.load();
+    const std::size_t stride = getPointStride();
+    ScopeGeometry& geometry = m_geometry.back();
+    geometry.strip.clear();
+    geometry.newestSample = captureTime;
+
+    // The density histogram is fed from m_densityPoints; only the timestamp is needed
+    const RenderMode mode = m_renderMode.load(std::memory_order_relaxed);
+    if (mode == RenderMode::Density) {
+        return;
+    }
+    if (mode == RenderMode::TimeDomain) {
+        buildSweepGeometry(geometry);
         return;
     }
 
-    for (std::size_t i = 0; i < center_line_points.size(); i++) {
-        sf::Color oc = center_line_points[i].color;
-        float da = 255.f*static_cast<float>(i)/static_cast<float>(center_line_points.size());
-        uint8_t alpha = 0;
-        if (alpha_values[i] >= da) {
-            alpha = alpha_values[i]-static_cast<uint8_t>(da);
-        }
-        center_line_points[i].color = sf::Color(oc.r, oc.g, oc.b, static_cast<uint8_t>(alpha));
+    // Never outgrow the slot's preallocated strip; the render thread grows it.
+    // With a stride, the strip spans the same history with fewer points
+    const std::size_t shown = std::min<std::size_t>(history.count, maxPersistentSamples.load());
+    const std::size_t pointCount = std::min(shown / stride, geometry.strip.capacity() / 2);
+    if (pointCount < 2) {
+        return;
     }
 
-    for (std::size_t i = 0; i < center_line_points.size(); ++i) {
-        const sf::Vertex& P_i = center_line_points[i];
+    for (std::size_t i = 0; i < pointCount; ++i) {
+        const TraceHistory::Point& P_i = history[i * stride];
         sf::Vector2f normal_vec;
 
         if (i == 0) {
-            const sf::Vertex& P_next = center_line_points[i + 1];
+            const TraceHistory::Point& P_next = history[(i + 1) * stride];
             sf::Vector2f tangent = normalize(P_next.position - P_i.position);
             normal_vec = perpendicular(tangent);
-        } else if (i == center_line_points.size() - 1) {
-            const sf::Vertex& P_prev = center_line_points[i - 1];
+        } else if (i == pointCount - 1) {
+            const TraceHistory::Point& P_prev = history[(i - 1) * stride];
             sf::Vector2f tangent = normalize(P_i.position - P_prev.position);
             normal_vec = perpendicular(tangent);
         } else {
-            const sf::Vertex& P_prev = center_line_points[i - 1];
-            const sf::Vertex& P_next = center_line_points[i + 1];
+            const TraceHistory::Point& P_prev = history[(i - 1) * stride];
+            const TraceHistory::Point& P_next = history[(i + 1) * stride];
             sf::Vector2f tangent_prev = normalize(P_i.position - P_prev.position);
             sf::Vector2f tangent_next = normalize(P_next.position - P_i.position);
             sf::Vector2f n1 = perpendicular(tangent_prev);
@@ -181,18 +676,111 @@ void Oscilloscope::processSamples(const std::int16_t* samples, std::size_t sampl
             normal_vec = sf::Vector2f(0.f, 1.f);
         }
 
-        sf::Vertex v_strip_top(P_i.position + normal_vec * (m_thickness / 2.f), P_i.color);
-        sf::Vertex v_strip_bottom(P_i.position - normal_vec * (m_thickness / 2.f), P_i.color);
+        // Fade older points out across the length of the trace
+        float da = 255.f*static_cast<float>(i)/static_cast<float>(pointCount);
+        uint8_t alpha = 0;
+        if (P_i.color.a >= da) {
+            alpha = P_i.color.a-static_cast<uint8_t>(da);
+        }
+        const sf::Color faded(P_i.color.r, P_i.color.g, P_i.color.b, alpha);
 
-        m_triangle_strip.append(v_strip_top);
-        m_triangle_strip.append(v_strip_bottom);
+        geometry.strip.push_back(sf::Vertex(P_i.position + normal_vec * (thickness / 2.f), faded));
+        geometry.strip.push_back(sf::Vertex(P_i.position - normal_vec * (thickness / 2.f), faded));
     }
 }
 
-void Oscilloscope::draw(sf::RenderTarget& target, sf::RenderStates states) const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_triangle_strip.getVertexCount() == 0) {
-        return;
+void Oscilloscope::buildSweepGeometry(ScopeGeometry& geometry) {
+    const sf::Vector2f center(m_center_x.load(), m_center_y.load());
+    const float radius = m_radius.load();
+    // Each channel gets half the height: x on top, y below
+    const float amplitude = radius / 2.f * scale.load();
+    const float halfWidth = m_thickness.load() / 2.f;
+    const std::size_t stride = getPointStride();
+    const sf::Color color(trace_color.load());
+    const std::size_t sweeps = std::min<std::size_t>(m_sweepCount.load(), m_sweeps.sweepCount());
+
+    // Oldest first, so the newest sweep ends up on top
+    for (std::size_t age = sweeps; age-- > 0;) {
+        const SweepCapture::Sweep& sweep = m_sweeps.sweep(age);
+        const auto alpha = static_cast<std::uint8_t>(color.a * (sweeps - age) / sweeps);
+        const float columnWidth = 2.f * radius / static_cast<float>(sweep.columnCount);
+
+        for (unsigned int channel = 0; channel < 2; ++channel) {
+            const float baseline = center.y + (channel == 0 ? -radius : radius) / 2.f;
+            const auto& columns = sweep.columns[channel];
+            std::size_t count = 0;
+            // With a stride, neighbouring columns are merged, which keeps every peak
+            for (std::size_t c = 0; c < sweep.columnCount; c += stride) {
+                const std::size_t end = std::min(c + stride, sweep.columnCount);
+                SweepCapture::Column merged = columns[c];
+                for (std::size_t k = c + 1; k < end; ++k) {
+                    merged.low = std::min(merged.low, columns[k].low);
+                    merged.high = std::max(merged.high, columns[k].high);
+                }
+                merged.last = columns[end - 1].last;
+
+                // Draw the extremes in the order the signal most likely visited them
+                const bool rising = merged.last >= merged.first;
+                const float x = center.x - radius + columnWidth * static_cast<float>(c);
+                const float width = columnWidth * static_cast<float>(end - c);
+                m_sweepPoints[count++] = {x, baseline - (rising ? merged.low : merged.high) * amplitude};
+                m_sweepPoints[count++] = {x + width / 2.f, baseline - (rising ? merged.high : merged.low) * amplitude};
+            }
+            if (!appendPolyline(geometry.strip, m_sweepPoints.data(), count, halfWidth,
+                                sf::Color(color.r, color.g, color.b, alpha))) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename Sample, std::size_t Stride>
+void Oscilloscope::ingest(const void* frames, std::size_t frameCount, std::size_t frameStride,
+                          std::chrono::steady_clock::time_point captureTime) {
+    processSamples<Sample, Stride>(static_cast<const Sample*>(frames), frameCount, frameStride, captureTime);
+}
+
+Oscilloscope::IngestFn Oscilloscope::ingestFor(SampleFormat format, std::size_t frameStride) {
+    // Rows by format, columns by stride: runtime, 2, 4, 8, 16
+    static constexpr IngestFn table[4][5] = {
+        {&Oscilloscope::ingest<std::int16_t, 0>, &Oscilloscope::ingest<std::int16_t, 2>, &Oscilloscope::ingest<std::int16_t, 4>,
+         &Oscilloscope::ingest<std::int16_t, 8>, &Oscilloscope::ingest<std::int16_t, 16>},
+        {&Oscilloscope::ingest<Int24, 0>, &Oscilloscope::ingest<Int24, 2>, &Oscilloscope::ingest<Int24, 4>,
+         &Oscilloscope::ingest<Int24, 8>, &Oscilloscope::ingest<Int24, 16>},
+        {&Oscilloscope::ingest<std::int32_t, 0>, &Oscilloscope::ingest<std::int32_t, 2>, &Oscilloscope::ingest<std::int32_t, 4>,
+         &Oscilloscope::ingest<std::int32_t, 8>, &Oscilloscope::ingest<std::int32_t, 16>},
+        {&Oscilloscope::ingest<float, 0>, &Oscilloscope::ingest<float, 2>, &Oscilloscope::ingest<float, 4>,
+         &Oscilloscope::ingest<float, 8>, &Oscilloscope::ingest<float, 16>},
+    };
+
+    std::size_t column = 0;
+    switch (frameStride) {
+        case 2: column = 1; break;
+        case 4: column = 2; break;
+        case 8: column = 3; break;
+        case 16: column = 4; break;
+        default: break;
+    }
+    std::size_t row = 0;
+    switch (format) {
+        case SampleFormat::Int16: row = 0; break;
+        case SampleFormat::Int24: row = 1; break;
+        case SampleFormat::Int32: row = 2; break;
+        case SampleFormat::Float32: row = 3; break;
     }
-    target.draw(m_triangle_strip, states);
+    return table[row][column];
 }
+
+#define OSCAR_INSTANTIATE_PROCESS_SAMPLES(Sample) \
+    template void Oscilloscope::processSamples<Sample, 0>(const Sample*, std::size_t, std::size_t, std::chrono::steady_clock::time_point); \
+    template void Oscilloscope::processSamples<Sample, 2>(const Sample*, std::size_t, std::size_t, std::chrono::steady_clock::time_point); \
+    template void Oscilloscope::processSamples<Sample, 4>(const Sample*, std::size_t, std::size_t, std::chrono::steady_clock::time_point); \
+    template void Oscilloscope::processSamples<Sample, 8>(const Sample*, std::size_t, std::size_t, std::chrono::steady_clock::time_point); \
+    template void Oscilloscope::processSamples<Sample, 16>(const Sample*, std::size_t, std::size_t, std::chrono::steady_clock::time_point);
+
+OSCAR_INSTANTIATE_PROCESS_SAMPLES(std::int16_t)
+OSCAR_INSTANTIATE_PROCESS_SAMPLES(Int24)
+OSCAR_INSTANTIATE_PROCESS_SAMPLES(std::int32_t)
+OSCAR_INSTANTIATE_PROCESS_SAMPLES(float)
+
+#undef OSCAR_INSTANTIATE_PROCESS_SAMPLES
@@ -0,0 +1,108 @@
+#include "include/quality_governor.hpp"
+
+#include <algorithm>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr QualitySettings kLevels[QualityGovernor::kLevelCount] = {
+    {1, 4, 1.f},
+    {2, 4, 1.f},
+    {4, 4, 1.f},
+    {4, 2, 1.f},
+    {4, 0, 0.75f},
+    {4, 0, 0.5f},
+};
+
+// Smoothing of the frame and work time averages
+constexpr double kAverageWeight = 0.1;
+
+// Overloaded: frames arrive late, or the work alone nearly fills the frame
+constexpr double kLateFrame = 1.10;
+constexpr double kHeavyWork = 0.90;
+// Headroom: frames on time and the work would still fit if it doubled
+constexpr double kOnTimeFrame = 1.05;
+constexpr double kLightWork = 0.45;
+
+// How long a condition must hold, and how long after a change before measuring again
+constexpr auto kDegradeAfter = 250ms;
+constexpr auto kSettleAfterChange = 500ms;
+constexpr auto kRestoreHoldMin = std::chrono::duration_cast<std::chrono::steady_clock::duration>(2s);
+constexpr auto kRestoreHoldMax = std::chrono::duration_cast<std::chrono::steady_clock::duration>(32s);
+// A restore followed by an overload this soon counts as failed
+constexpr auto kFailedRestoreWindow = 5s;
+
+} // namespace
+
+const QualitySettings& QualityGovernor::settings(unsigned int level) {
+    return kLevels[std::min(level, kLevelCount - 1)];
+}
+
+QualityGovernor::QualityGovernor(double targetFrameMs, bool locked)
+    : m_targetFrameMs(targetFrameMs), m_locked(locked), m_restoreHold(kRestoreHoldMin) {
+}
+
+void QualityGovernor::setLocked(bool locked) {
+    m_locked = locked;
+}
+
+void QualityGovernor::changeLevel(unsigned int level, std::chrono::steady_clock::time_point now) {
+    m_level.store(level, std::memory_order_relaxed);
+    m_lastChange = now;
+    m_overloaded = false;
+    m_headroom = false;
+}
+
+bool QualityGovernor::update(double frameMs, double workMs, std::chrono::steady_clock::time_point now) {
+    if (!m_primed) {
+        m_frameMs = frameMs;
+        m_workMs = workMs;
+        m_lastChange = now;
+        m_primed = true;
+    } else {
+        m_frameMs = m_frameMs + kAverageWeight * (frameMs - m_frameMs);
+        m_workMs = m_workMs + kAverageWeight * (workMs - m_workMs);
+    }
+
+    const unsigned int current = level();
+    if (isLocked()) {
+        if (current != 0) {
+            changeLevel(0, now);
+            return true;
+        }
+        return false;
+    }
+    if (now - m_lastChange < kSettleAfterChange) {
+        return false;
+    }
+
+    const bool overloaded = m_frameMs > kLateFrame * m_targetFrameMs || m_workMs > kHeavyWork * m_targetFrameMs;
+    const bool headroom = m_frameMs < kOnTimeFrame * m_targetFrameMs && m_workMs < kLightWork * m_targetFrameMs;
+    if (overloaded && !m_overloaded) {
+        m_overloadSince = now;
+    }
+    if (headroom && !m_headroom) {
+        m_headroomSince = now;
+    }
+    m_overloaded = overloaded;
+    m_headroom = headroom;
+
+    if (overloaded && current + 1 < kLevelCount && now - m_overloadSince >= kDegradeAfter) {
+        if (now - m_lastRestore < kFailedRestoreWindow) {
+            m_restoreHold = std::min(m_restoreHold * 2, kRestoreHoldMax);
+        }
+        changeLevel(current + 1, now);
+        return true;
+    }
+    if (headroom && current > 0 && now - m_headroomSince >= m_restoreHold) {
+        if (now - m_lastRestore > kRestoreHoldMax) {
+            // Restores have been sticking for a while; stop penalizing
+            m_restoreHold = kRestoreHoldMin;
+        }
+        m_lastRestore = now;
+        changeLevel(current - 1, now);
+        return true;
+    }
+    return false;
+}
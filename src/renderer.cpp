@@ -0,0 +1,174 @@
+#include "include/renderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+Renderer::Renderer(std::size_t output, unsigned int densityThreads)
+    : output(output), densityThreads(densityThreads) {
+}
+
+bool Renderer::init(const sf::Vector2u& size) {
+    if (!gaussianBlurShader.loadFromFile("blur.frag", sf::Shader::Type::Fragment)) {
+        std::cerr << "Error: Could not load blur.frag shader." << std::endl;
+        return false;
+    }
+    gaussianBlurShader.setUniform("texture", sf::Shader::CurrentTexture);
+    gaussianBlurShader.setUniform("blur_taps", static_cast<int>(quality.blurTaps));
+    resize(size);
+    return true;
+}
+
+void Renderer::resize(const sf::Vector2u& size) {
+    targetSize = size;
+    compositeTexture = sf::RenderTexture(size);
+    allocateTextures();
+}
+
+void Renderer::allocateTextures() {
+    scaledSize = {std::max(1u, static_cast<unsigned int>(std::lround(targetSize.x * quality.renderScale))),
+                  std::max(1u, static_cast<unsigned int>(std::lround(targetSize.y * quality.renderScale)))};
+    traceTexture = sf::RenderTexture(scaledSize);
+    blurTexture = sf::RenderTexture(scaledSize);
+    frameTexture = sf::RenderTexture(scaledSize);
+
+    // Histograms are sized lazily by drawDensity()
+    for (DensityLayer& layer : densityLayers) {
+        layer.active = false;
+    }
+}
+
+void Renderer::setQuality(const QualitySettings& settings) {
+    const bool rescale = settings.renderScale != quality.renderScale;
+    quality = settings;
+    gaussianBlurShader.setUniform("blur_taps", static_cast<int>(quality.blurTaps));
+    if (rescale) {
+        allocateTextures();
+    }
+}
+
+void Renderer::enableExport(const std::string& shmName, unsigned int slotCount) {
+    exporter = std::make_unique<FrameExporter>(shmName, slotCount);
+}
+
+sf::FloatRect Renderer::sceneRect(const Oscilloscope& scope) const {
+    const sf::Vector2f size(static_cast<float>(targetSize.x), static_cast<float>(targetSize.y));
+    const float radius = scope.getViewRadius();
+    if (radius <= 0.f || size.x <= 0.f || size.y <= 0.f) {
+        return sf::FloatRect({0.f, 0.f}, size);
+    }
+    // Full scale touches the shorter side of the output, as it does on the output the scope was laid out for
+    const sf::Vector2f scene = size * (2.f * radius / std::min(size.x, size.y));
+    return sf::FloatRect(scope.getViewCenter() - scene / 2.f, scene);
+}
+
+void Renderer::drawDensity(Oscilloscope& scope, DensityLayer& layer) {
+    FrameRing& points = scope.densityPoints(output);
+    const auto now = std::chrono::steady_clock::now();
+    if (!densityWorkers) {
+        densityWorkers = std::make_unique<WorkerPool>(densityThreads);
+    }
+    if (!layer.active) {
+        // Start from an empty histogram; anything queued is from before the switch or resize
+        points.consume(points.available());
+        layer.histogram.resize(scaledSize);
+        const sf::Vector2u size = layer.histogram.size();
+        if (layer.texture.getSize() != size && !layer.texture.resize(size)) {
+            std::cerr << "Error: Could not allocate the density texture." << std::endl;
+            return;
+        }
+        layer.texture.setSmooth(size != scaledSize);
+        layer.lastUpdate = now;
+        layer.active = true;
+    }
+
+    // Exponential decay by the real frame time, so the look does not depend on the frame rate
+    const float dt = std::min(std::chrono::duration<float>(now - layer.lastUpdate).count(), 1.f);
+    layer.lastUpdate = now;
+    const float decay = std::exp(-dt / scope.getDensityDecay());
+
+    const sf::FloatRect scene = sceneRect(scope);
+    const std::size_t count = points.available();
+    const sf::Vector2u size = layer.histogram.size();
+    layer.histogram.update(points, count, scene.position, static_cast<float>(size.x) / scene.size.x, decay,
+                           scope.getDensityGamma(), scope.getTraceColor(), *densityWorkers);
+    points.consume(count);
+
+    // The histogram is at the texture's resolution, capped below large targets and scaled up to fill them
+    layer.texture.update(layer.histogram.pixels());
+    traceTexture.setView(traceTexture.getDefaultView());
+    sf::Sprite sprite(layer.texture);
+    sprite.setScale({static_cast<float>(scaledSize.x) / static_cast<float>(size.x),
+                     static_cast<float>(scaledSize.y) / static_cast<float>(size.y)});
+    traceTexture.draw(sprite);
+}
+
+std::chrono::steady_clock::time_point Renderer::render(sf::RenderTarget& target, std::span<Oscilloscope* const> scopes) {
+    std::chrono::steady_clock::time_point newestSample{};
+
+    // When exporting, layer the scopes into the composite texture so the final
+    // frame exists somewhere it can be read back from
+    sf::RenderTarget& layerTarget = exporter ? static_cast<sf::RenderTarget&>(compositeTexture) : target;
+    if (exporter) {
+        compositeTexture.clear(sf::Color::Transparent);
+    }
+
+    if (densityLayers.size() < scopes.size()) {
+        densityLayers.resize(scopes.size());
+    }
+
+    for (std::size_t i = 0; i < scopes.size(); ++i) {
+        Oscilloscope& scope = *scopes[i];
+        DensityLayer& density = densityLayers[i];
+        scope.acquireGeometry(output);
+        const ScopeGeometry& geometry = scope.geometry(output);
+        newestSample = std::max(newestSample, geometry.newestSample);
+
+        traceTexture.clear(sf::Color::Transparent);
+        if (scope.getRenderMode() == RenderMode::Density) {
+            drawDensity(scope, density);
+        } else {
+            density.active = false;
+            // The view also absorbs the render scale
+            traceTexture.setView(sf::View(sceneRect(scope)));
+            if (!geometry.strip.empty()) {
+                traceTexture.draw(geometry.strip.data(), geometry.strip.size(), sf::PrimitiveType::TriangleStrip);
+            }
+        }
+
+        traceTexture.display();
+
+        sf::Sprite layer(traceTexture.getTexture());
+        if (quality.blurTaps > 0) {
+            gaussianBlurShader.setUniform("texture", compositeTexture.getTexture());
+            gaussianBlurShader.setUniform("texture_size", sf::Glsl::Vec2(traceTexture.getSize()));
+            gaussianBlurShader.setUniform("blur_direction", sf::Glsl::Vec2(1.f, 0.f));
+            // Spread is set in window pixels
+            gaussianBlurShader.setUniform("blur_spread_px", scope.getBlurSpread() * quality.renderScale);
+
+            blurTexture.clear(sf::Color::Transparent);
+            blurTexture.draw(sf::Sprite(traceTexture.getTexture()), &gaussianBlurShader);
+            blurTexture.display();
+
+            gaussianBlurShader.setUniform("texture", blurTexture.getTexture());
+            gaussianBlurShader.setUniform("blur_direction", sf::Glsl::Vec2(0.f, 1.f));
+
+            frameTexture.clear(sf::Color::Transparent);
+            frameTexture.draw(sf::Sprite(blurTexture.getTexture()), &gaussianBlurShader);
+            frameTexture.display();
+
+            layer = sf::Sprite(frameTexture.getTexture());
+        }
+        // Scale the layer back up to the window
+        layer.setScale({static_cast<float>(targetSize.x) / static_cast<float>(scaledSize.x),
+                        static_cast<float>(targetSize.y) / static_cast<float>(scaledSize.y)});
+        layerTarget.draw(layer);
+    }
+
+    if (exporter) {
+        compositeTexture.display();
+        exporter->capture(compositeTexture);
+        target.draw(sf::Sprite(compositeTexture.getTexture()));
+    }
+
+    return newestSample;
+}
@@ -0,0 +1,312 @@
+#include "include/rt_check.hpp"
+
+#ifdef OSCAR_RT_CHECK
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#if defined(__GLIBC__)
+#define RTCHECK_INTERPOSE 1
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// glibc's own entry points, used to forward the interposed calls
+extern "C" {
+void* __libc_malloc(std::size_t size) noexcept;
+void* __libc_calloc(std::size_t count, std::size_t size) noexcept;
+void* __libc_realloc(void* ptr, std::size_t size) noexcept;
+void* __libc_memalign(std::size_t alignment, std::size_t size) noexcept;
+void __libc_free(void* ptr) noexcept;
+ssize_t __write(int fd, const void* buf, std::size_t n);
+std::size_t _IO_fwrite(const void* ptr, std::size_t size, std::size_t n, FILE* stream);
+int _IO_fputs(const char* s, FILE* stream);
+int _IO_puts(const char* s);
+int _IO_putc(int c, FILE* stream);
+int _IO_fflush(FILE* stream);
+}
+#endif
+
+namespace rtcheck {
+
+namespace {
+
+constexpr int kMaxFrames = 32;
+constexpr std::size_t kMaxSites = 64;
+
+// One distinct violating call: what was called and the stack it was called from
+struct Site {
+    std::atomic<std::uint64_t> key{0};
+    std::atomic<bool> ready{false};
+    std::atomic<std::uint64_t> count{0};
+    const char* what = nullptr;
+    void* frames[kMaxFrames] = {};
+    int depth = 0;
+};
+
+constinit Site g_sites[kMaxSites];
+constinit std::atomic<std::uint64_t> g_violations{0};
+constinit std::atomic<std::uint64_t> g_unrecorded{0};
+
+constinit thread_local int t_sectionDepth = 0;
+constinit thread_local bool t_inHook = false;
+
+} // namespace
+
+#ifdef RTCHECK_INTERPOSE
+
+namespace {
+
+// Runs inside malloc and friends, so it must not allocate, lock or print itself
+void recordViolation(const char* what) {
+    if (t_sectionDepth == 0 || t_inHook) {
+        return;
+    }
+    t_inHook = true;
+    g_violations.fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[kMaxFrames];
+    const int depth = backtrace(frames, kMaxFrames);
+
+    // FNV-1a over the call kind and return addresses identifies the site
+    std::uint64_t key = 1469598103934665603ull;
+    auto mix = [&key](std::uintptr_t v) { key = (key ^ v) * 1099511628211ull; };
+    mix(reinterpret_cast<std::uintptr_t>(what));
+    for (int i = 0; i < depth; ++i) {
+        mix(reinterpret_cast<std::uintptr_t>(frames[i]));
+    }
+    if (key == 0) {
+        key = 1;
+    }
+
+    std::size_t slot = key % kMaxSites;
+    for (std::size_t probe = 0; probe < kMaxSites; ++probe, slot = (slot + 1) % kMaxSites) {
+        Site& site = g_sites[slot];
+        std::uint64_t expected = 0;
+        if (site.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+            site.what = what;
+            std::memcpy(site.frames, frames, sizeof(void*) * static_cast<std::size_t>(depth));
+            site.depth = depth;
+            site.ready.store(true, std::memory_order_release);
+        } else if (expected != key) {
+            continue;
+        }
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        t_inHook = false;
+        return;
+    }
+    g_unrecorded.fetch_add(1, std::memory_order_relaxed);
+    t_inHook = false;
+}
+
+using MutexLockFn = int (*)(pthread_mutex_t*);
+std::atomic<MutexLockFn> g_mutexLock{nullptr};
+
+MutexLockFn realMutexLock() {
+    MutexLockFn fn = g_mutexLock.load(std::memory_order_acquire);
+    if (!fn) {
+        fn = reinterpret_cast<MutexLockFn>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        g_mutexLock.store(fn, std::memory_order_release);
+    }
+    return fn;
+}
+
+void* allocateOrThrow(std::size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* ptr = __libc_malloc(size)) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+#endif // RTCHECK_INTERPOSE
+
+RealtimeSection::RealtimeSection() {
+    ++t_sectionDepth;
+}
+
+RealtimeSection::~RealtimeSection() {
+    --t_sectionDepth;
+}
+
+void init() {
+#ifdef RTCHECK_INTERPOSE
+    realMutexLock();
+    // The first backtrace() loads the unwinder, which allocates
+    void* frames[kMaxFrames];
+    backtrace(frames, kMaxFrames);
+#endif
+}
+
+std::uint64_t violationCount() {
+    return g_violations.load(std::memory_order_relaxed);
+}
+
+void printSummary() {
+#ifndef RTCHECK_INTERPOSE
+    std::cerr << "RT check: call interposition is only supported with glibc; nothing was checked." << std::endl;
+#else
+    const std::uint64_t total = violationCount();
+    if (total == 0) {
+        std::cerr << "RT check: no allocations, locks or I/O in realtime sections." << std::endl;
+        return;
+    }
+    std::cerr << "RT check: " << total << " realtime violations" << std::endl;
+    for (const Site& site : g_sites) {
+        if (!site.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        std::cerr << "RT check: " << site.count.load() << "x " << site.what << " in realtime section, from:" << std::endl;
+        backtrace_symbols_fd(site.frames, site.depth, STDERR_FILENO);
+    }
+    if (const std::uint64_t unrecorded = g_unrecorded.load()) {
+        std::cerr << "RT check: " << unrecorded << " further violations from sites beyond the first " << kMaxSites << std::endl;
+    }
+#endif
+}
+
+} // namespace rtcheck
+
+#ifdef RTCHECK_INTERPOSE
+
+// --- Interposed allocation ---
+
+extern "C" void* malloc(std::size_t size) noexcept {
+    rtcheck::recordViolation("malloc");
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size) noexcept {
+    rtcheck::recordViolation("calloc");
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, std::size_t size) noexcept {
+    rtcheck::recordViolation("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr) noexcept {
+    if (ptr) {
+        rtcheck::recordViolation("free");
+    }
+    __libc_free(ptr);
+}
+
+extern "C" void* memalign(std::size_t alignment, std::size_t size) noexcept {
+    rtcheck::recordViolation("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+    rtcheck::recordViolation("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void** out, std::size_t alignment, std::size_t size) noexcept {
+    rtcheck::recordViolation("posix_memalign");
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+// The remaining (aligned, nothrow) forms of new and delete are implemented
+// by libstdc++ on top of these or of malloc, so they are covered as well
+void* operator new(std::size_t size) {
+    rtcheck::recordViolation("operator new");
+    return rtcheck::allocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+    rtcheck::recordViolation("operator new[]");
+    return rtcheck::allocateOrThrow(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) {
+        rtcheck::recordViolation("operator delete");
+    }
+    __libc_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    if (ptr) {
+        rtcheck::recordViolation("operator delete[]");
+    }
+    __libc_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete[](ptr);
+}
+
+// --- Interposed blocking lock ---
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    rtcheck::recordViolation("pthread_mutex_lock");
+    return rtcheck::realMutexLock()(mutex);
+}
+
+// --- Interposed output (std::cout/std::cerr end up in fwrite/putc/fflush) ---
+
+extern "C" ssize_t write(int fd, const void* buf, std::size_t n) {
+    rtcheck::recordViolation("write");
+    return __write(fd, buf, n);
+}
+
+extern "C" std::size_t fwrite(const void* ptr, std::size_t size, std::size_t n, FILE* stream) {
+    rtcheck::recordViolation("fwrite");
+    return _IO_fwrite(ptr, size, n, stream);
+}
+
+extern "C" int fputs(const char* s, FILE* stream) {
+    rtcheck::recordViolation("fputs");
+    return _IO_fputs(s, stream);
+}
+
+extern "C" int puts(const char* s) {
+    rtcheck::recordViolation("puts");
+    return _IO_puts(s);
+}
+
+extern "C" int putc(int c, FILE* stream) {
+    rtcheck::recordViolation("putc");
+    return _IO_putc(c, stream);
+}
+
+extern "C" int fflush(FILE* stream) {
+    rtcheck::recordViolation("fflush");
+    return _IO_fflush(stream);
+}
+
+#endif // RTCHECK_INTERPOSE
+
+#endif // OSCAR_RT_CHECK
@@ -0,0 +1,212 @@
+#include "include/shm_frame.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace shmframe {
+
+namespace {
+
+std::size_t alignUp(std::size_t n, std::size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// --- Writer ---
+
+FrameRingWriter::~FrameRingWriter() {
+    close();
+}
+
+bool FrameRingWriter::create(const std::string& name, std::uint32_t slotCount, std::size_t maxFrameBytes) {
+    close();
+
+    const std::size_t slotStride = alignUp(sizeof(SlotHeader) + maxFrameBytes, kHeaderAlign);
+    const std::size_t totalBytes = sizeof(RingHeader) + slotStride * slotCount;
+
+    // Replace any segment left behind by a previous run
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create shared memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(totalBytes)) != 0) {
+        std::cerr << "Failed to size shared memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* mapped = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory segment " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_base = static_cast<std::uint8_t*>(mapped);
+    m_mappedBytes = totalBytes;
+    m_maxFrameBytes = maxFrameBytes;
+    m_sequence = 0;
+
+    auto* header = new (m_base) RingHeader{};
+    header->magic = kMagic;
+    header->version = kVersion;
+    header->slotCount = slotCount;
+    header->slotStride = slotStride;
+    header->maxFrameBytes = maxFrameBytes;
+    for (std::uint32_t i = 0; i < slotCount; ++i) {
+        new (m_base + sizeof(RingHeader) + slotStride * i) SlotHeader{};
+    }
+    header->latestSequence.store(0, std::memory_order_release);
+    header->valid.store(1, std::memory_order_release);
+    return true;
+}
+
+void FrameRingWriter::close() {
+    if (!m_base) {
+        return;
+    }
+    reinterpret_cast<RingHeader*>(m_base)->valid.store(0, std::memory_order_release);
+    munmap(m_base, m_mappedBytes);
+    shm_unlink(m_name.c_str());
+    m_base = nullptr;
+    m_mappedBytes = 0;
+    m_maxFrameBytes = 0;
+}
+
+SlotHeader* FrameRingWriter::slot(std::uint64_t sequence) const {
+    const auto* header = reinterpret_cast<const RingHeader*>(m_base);
+    return reinterpret_cast<SlotHeader*>(m_base + sizeof(RingHeader) + header->slotStride * (sequence % header->slotCount));
+}
+
+std::uint8_t* FrameRingWriter::beginFrame() {
+    SlotHeader* s = slot(m_sequence + 1);
+    s->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return reinterpret_cast<std::uint8_t*>(s) + sizeof(SlotHeader);
+}
+
+void FrameRingWriter::commitFrame(std::uint64_t timestampNs, std::uint32_t width, std::uint32_t height,
+                                  std::uint32_t stride, PixelFormat format, std::uint32_t flags) {
+    ++m_sequence;
+    SlotHeader* s = slot(m_sequence);
+    s->timestampNs = timestampNs;
+    s->width = width;
+    s->height = height;
+    s->stride = stride;
+    s->size = stride * height;
+    s->format = format;
+    s->flags = flags;
+    s->sequence.store(m_sequence, std::memory_order_release);
+    reinterpret_cast<RingHeader*>(m_base)->latestSequence.store(m_sequence, std::memory_order_release);
+}
+
+// --- Reader ---
+
+FrameRingReader::~FrameRingReader() {
+    close();
+}
+
+bool FrameRingReader::open(const std::string& name) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(RingHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const auto totalBytes = static_cast<std::size_t>(st.st_size);
+    void* mapped = mmap(nullptr, totalBytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* header = static_cast<const RingHeader*>(mapped);
+    if (header->magic != kMagic || header->version != kVersion ||
+        sizeof(RingHeader) + header->slotStride * header->slotCount > totalBytes) {
+        std::cerr << "Shared memory segment " << name << " has an unexpected layout." << std::endl;
+        munmap(mapped, totalBytes);
+        return false;
+    }
+
+    m_base = static_cast<const std::uint8_t*>(mapped);
+    m_mappedBytes = totalBytes;
+    return true;
+}
+
+void FrameRingReader::close() {
+    if (m_base) {
+        munmap(const_cast<std::uint8_t*>(m_base), m_mappedBytes);
+        m_base = nullptr;
+        m_mappedBytes = 0;
+    }
+}
+
+bool FrameRingReader::isValid() const {
+    return m_base && reinterpret_cast<const RingHeader*>(m_base)->valid.load(std::memory_order_acquire) != 0;
+}
+
+std::uint64_t FrameRingReader::latestSequence() const {
+    return m_base ? reinterpret_cast<const RingHeader*>(m_base)->latestSequence.load(std::memory_order_acquire) : 0;
+}
+
+std::size_t FrameRingReader::maxFrameBytes() const {
+    return m_base ? reinterpret_cast<const RingHeader*>(m_base)->maxFrameBytes : 0;
+}
+
+bool FrameRingReader::readLatest(std::uint64_t lastSequence, FrameInfo& info, std::uint8_t* pixels) const {
+    if (!m_base) {
+        return false;
+    }
+    const auto* header = reinterpret_cast<const RingHeader*>(m_base);
+    const std::uint64_t sequence = header->latestSequence.load(std::memory_order_acquire);
+    if (sequence == 0 || sequence == lastSequence) {
+        return false;
+    }
+
+    const auto* s = reinterpret_cast<const SlotHeader*>(
+        m_base + sizeof(RingHeader) + header->slotStride * (sequence % header->slotCount));
+    if (s->sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+
+    info.sequence = sequence;
+    info.timestampNs = s->timestampNs;
+    info.width = s->width;
+    info.height = s->height;
+    info.stride = s->stride;
+    info.size = s->size;
+    info.format = s->format;
+    info.flags = s->flags;
+    if (info.size > header->maxFrameBytes) {
+        return false;
+    }
+    std::memcpy(pixels, reinterpret_cast<const std::uint8_t*>(s) + sizeof(SlotHeader), info.size);
+
+    // The writer may have lapped the ring while we copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s->sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+} // namespace shmframe
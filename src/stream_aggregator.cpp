@@ -0,0 +1,250 @@
+#include "include/stream_aggregator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+// Drift controller: proportional and integral gains on the level error (s)
+constexpr double kRateKp = 0.2;
+constexpr double kRateKi = 0.02;
+constexpr double kMaxRateDeviation = 0.005;
+constexpr double kLevelSmoothing = 0.05;
+// A level this many targets above the target means the consumer stalled; drop the backlog
+constexpr double kBacklogTargets = 4.0;
+constexpr std::size_t kMinRingFrames = 16384;
+constexpr unsigned int kMaxBlockFrames = 4096;
+
+// Converts the channel pairs of each frame, writing pair k to pair pairs[k] of the frame dest(f)
+template <typename Sample, typename Dest>
+void convertPairs(const void* samples, std::size_t frameStride, unsigned int nFrames,
+                  const std::vector<unsigned int>& pairs, Dest&& dest) {
+    const auto* src = static_cast<const Sample*>(samples);
+    for (unsigned int f = 0; f < nFrames; ++f, src += frameStride) {
+        float* out = dest(f);
+        if (!out) {
+            continue; // Dropped (and counted) by the destination
+        }
+        for (std::size_t k = 0; k < pairs.size(); ++k) {
+            out[2 * pairs[k]] = sampleToUnit(src[2 * k]);
+            out[2 * pairs[k] + 1] = sampleToUnit(src[2 * k + 1]);
+        }
+    }
+}
+
+template <typename Dest>
+void convertPairs(SampleFormat format, const void* samples, std::size_t frameStride, unsigned int nFrames,
+                  const std::vector<unsigned int>& pairs, Dest&& dest) {
+    switch (format) {
+        case SampleFormat::Int16:
+            convertPairs<std::int16_t>(samples, frameStride, nFrames, pairs, dest);
+            break;
+        case SampleFormat::Int24:
+            convertPairs<Int24>(samples, frameStride, nFrames, pairs, dest);
+            break;
+        case SampleFormat::Int32:
+            convertPairs<std::int32_t>(samples, frameStride, nFrames, pairs, dest);
+            break;
+        case SampleFormat::Float32:
+            convertPairs<float>(samples, frameStride, nFrames, pairs, dest);
+            break;
+    }
+}
+
+} // namespace
+
+// --- DriftEstimator ---
+
+DriftEstimator::DriftEstimator(double nominalRatio) : m_nominalRatio(nominalRatio) {
+}
+
+void DriftEstimator::reset(double levelFrames) {
+    // Keep the integral: the clocks' skew has not changed
+    m_levelAverage = levelFrames;
+}
+
+double DriftEstimator::update(double levelFrames, double targetFrames, double producerRate, double dtSeconds) {
+    // Too much buffered means the producer runs fast: consume faster
+    m_levelAverage += (levelFrames - m_levelAverage) * kLevelSmoothing;
+    const double errorSeconds = (m_levelAverage - targetFrames) / producerRate;
+    m_integral = std::clamp(m_integral + kRateKi * errorSeconds * dtSeconds, -kMaxRateDeviation, kMaxRateDeviation);
+    m_correction = 1.0 + std::clamp(kRateKp * errorSeconds + m_integral, -kMaxRateDeviation, kMaxRateDeviation);
+    return ratio();
+}
+
+// --- StreamAggregator ---
+
+struct StreamAggregator::Stream {
+    std::vector<unsigned int> outputPairs;
+    std::vector<unsigned int> ringPairs;    // Identity mapping into the ring's frames
+    unsigned int sampleRate = 0;
+    unsigned int blockFrames = 0;
+    std::unique_ptr<FrameRing> ring;        // Not used by the master
+
+    // Consumer (master callback) state
+    DriftEstimator drift;
+    double targetFrames = 0.0;
+    double fraction = 0.0;                  // Read position within the oldest ring frame
+    bool buffering = true;
+
+    // Producer: arrival of the newest block, in steady-clock ticks
+    std::atomic<std::chrono::steady_clock::rep> lastPush{0};
+
+    // Published for stats()
+    std::atomic<double> ratio{1.0};
+    std::atomic<double> driftPpm{0.0};
+    std::atomic<double> levelFrames{0.0};
+    std::atomic<std::uint64_t> underruns{0};
+};
+
+StreamAggregator::StreamAggregator(unsigned int outputChannels, double marginMs, Sink sink)
+    : m_outputChannels(outputChannels), m_marginMs(marginMs), m_sink(std::move(sink)) {
+}
+
+StreamAggregator::~StreamAggregator() = default;
+
+std::size_t StreamAggregator::addStream(const std::vector<unsigned int>& outputPairs, unsigned int sampleRate,
+                                        unsigned int blockFrames) {
+    auto stream = std::make_unique<Stream>();
+    stream->outputPairs = outputPairs;
+    stream->ringPairs.resize(outputPairs.size());
+    std::iota(stream->ringPairs.begin(), stream->ringPairs.end(), 0u);
+    stream->sampleRate = sampleRate;
+    stream->blockFrames = blockFrames;
+
+    if (m_streams.empty()) {
+        m_blockCapacity = std::clamp(blockFrames, 1u, kMaxBlockFrames);
+        m_block.assign(static_cast<std::size_t>(m_blockCapacity) * m_outputChannels, 0.f);
+    } else {
+        const Stream& master = *m_streams.front();
+        const double nominalRatio = static_cast<double>(sampleRate) / master.sampleRate;
+        stream->drift = DriftEstimator(nominalRatio);
+        // One block of each side must fit on top of the margin, or the ring runs dry between callbacks
+        stream->targetFrames = blockFrames + master.blockFrames * nominalRatio + m_marginMs * sampleRate / 1000.0;
+        const auto ringFrames = static_cast<std::size_t>(stream->targetFrames * kBacklogTargets * 2.0);
+        stream->ring = std::make_unique<FrameRing>(std::max(ringFrames, kMinRingFrames), 2 * outputPairs.size());
+    }
+    m_streams.push_back(std::move(stream));
+    return m_streams.size() - 1;
+}
+
+void StreamAggregator::streamInput(std::size_t index, const void* samples, SampleFormat format, unsigned int nFrames,
+                                   std::size_t frameStride, double streamTime,
+                                   std::chrono::steady_clock::time_point arrival) {
+    Stream& stream = *m_streams[index];
+    const auto* bytes = static_cast<const std::uint8_t*>(samples);
+    const std::size_t frameBytes = frameStride * bytesPerSample(format);
+
+    if (index != 0) {
+        FrameRing& ring = *stream.ring;
+        convertPairs(format, samples, frameStride, nFrames, stream.ringPairs,
+                     [&ring](unsigned int) { return ring.beginPush(); });
+        stream.lastPush.store(arrival.time_since_epoch().count(), std::memory_order_relaxed);
+        ring.commitPush();
+        return;
+    }
+
+    // Master: build and deliver the aggregate block, in chunks if the callback block is unusually large
+    for (unsigned int done = 0; done < nFrames;) {
+        const unsigned int chunk = std::min(nFrames - done, m_blockCapacity);
+        float* block = m_block.data();
+        std::fill(block, block + static_cast<std::size_t>(chunk) * m_outputChannels, 0.f);
+
+        convertPairs(format, bytes + done * frameBytes, frameStride, chunk, stream.outputPairs,
+                     [this, block](unsigned int f) { return block + static_cast<std::size_t>(f) * m_outputChannels; });
+        for (std::size_t s = 1; s < m_streams.size(); ++s) {
+            pullResampled(*m_streams[s], block, chunk, arrival);
+        }
+
+        m_sink(block, chunk, m_outputChannels, streamTime + static_cast<double>(done) / stream.sampleRate);
+        done += chunk;
+    }
+}
+
+void StreamAggregator::pullResampled(Stream& stream, float* out, unsigned int nFrames,
+                                     std::chrono::steady_clock::time_point now) {
+    FrameRing& ring = *stream.ring;
+    const double dt = static_cast<double>(nFrames) / m_streams.front()->sampleRate;
+    std::size_t available = ring.available();
+    double level = static_cast<double>(available) - stream.fraction;
+
+    // The ring fills in whole slave blocks. Counting what the slave has captured since its last
+    // callback turns that sawtooth into a smooth level, which would otherwise alias into the
+    // drift estimate whenever the two callback cadences beat slowly against each other.
+    const auto sincePush = now - std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(stream.lastPush.load(std::memory_order_relaxed)));
+    const double pendingFrames = std::clamp(std::chrono::duration<double>(sincePush).count() * stream.sampleRate,
+                                            0.0, static_cast<double>(stream.blockFrames));
+
+    bool resync = false;
+    if (stream.buffering) {
+        if (level + pendingFrames < stream.targetFrames) {
+            // Still filling up to the target: this stream's channels stay silent
+            stream.levelFrames.store(level + pendingFrames, std::memory_order_relaxed);
+            return;
+        }
+        stream.buffering = false;
+        resync = true;
+    }
+    if (level + pendingFrames > stream.targetFrames * kBacklogTargets) {
+        // The master stalled (or started late): skip ahead rather than slowly draining the backlog
+        resync = true;
+    }
+    if (resync) {
+        // Start from exactly the target level. Any excess would otherwise be wound into the
+        // integral term and overshoot into underruns.
+        const auto excess = static_cast<std::size_t>(std::max(0.0, level + pendingFrames - stream.targetFrames));
+        ring.consume(excess);
+        available -= excess;
+        level -= static_cast<double>(excess);
+        stream.drift.reset(level + pendingFrames);
+    }
+
+    const double ratio = stream.drift.update(level + pendingFrames, stream.targetFrames, stream.sampleRate, dt);
+    double pos = stream.fraction;
+    for (unsigned int f = 0; f < nFrames; ++f) {
+        const auto whole = static_cast<std::size_t>(pos);
+        if (whole + 1 >= available) {
+            // Ran dry: leave the rest silent and rebuild the target level
+            ring.consume(std::min(whole, available));
+            stream.fraction = 0.0;
+            stream.buffering = true;
+            stream.underruns.fetch_add(1, std::memory_order_relaxed);
+            stream.levelFrames.store(0.0, std::memory_order_relaxed);
+            return;
+        }
+        const auto frac = static_cast<float>(pos - static_cast<double>(whole));
+        const float* a = ring.frame(whole);
+        const float* b = ring.frame(whole + 1);
+        float* dst = out + static_cast<std::size_t>(f) * m_outputChannels;
+        for (std::size_t k = 0; k < stream.outputPairs.size(); ++k) {
+            const unsigned int c = 2 * stream.outputPairs[k];
+            dst[c] = a[2 * k] + (b[2 * k] - a[2 * k]) * frac;
+            dst[c + 1] = a[2 * k + 1] + (b[2 * k + 1] - a[2 * k + 1]) * frac;
+        }
+        pos += ratio;
+    }
+
+    const auto consumed = static_cast<std::size_t>(pos);
+    ring.consume(consumed);
+    stream.fraction = pos - static_cast<double>(consumed);
+
+    stream.ratio.store(ratio, std::memory_order_relaxed);
+    stream.driftPpm.store(stream.drift.driftPpm(), std::memory_order_relaxed);
+    stream.levelFrames.store(stream.drift.levelFrames(), std::memory_order_relaxed);
+}
+
+StreamAggregator::StreamStats StreamAggregator::stats(std::size_t index) const {
+    const Stream& stream = *m_streams[index];
+    StreamStats s;
+    if (index == 0) {
+        return s;
+    }
+    s.ratio = stream.ratio.load(std::memory_order_relaxed);
+    s.driftPpm = stream.driftPpm.load(std::memory_order_relaxed);
+    s.levelMs = stream.levelFrames.load(std::memory_order_relaxed) * 1000.0 / stream.sampleRate;
+    s.targetMs = stream.targetFrames * 1000.0 / stream.sampleRate;
+    s.underruns = stream.underruns.load(std::memory_order_relaxed);
+    s.overflows = stream.ring->droppedFrames();
+    return s;
+}
@@ -0,0 +1,215 @@
+#include "include/sweep_capture.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Index of the first sample below (Below) or at least (!Below) the threshold, or count if there is none.
+// Most chunks hold no crossing at all, so the vector loop only tests for a hit per 16 samples.
+template <bool Below>
+std::size_t findFirst(const float* data, std::size_t count, float threshold) {
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 t = _mm_set1_ps(threshold);
+    auto hits = [t](const float* p) {
+        const __m128 v = _mm_loadu_ps(p);
+        return static_cast<unsigned int>(_mm_movemask_ps(Below ? _mm_cmplt_ps(v, t) : _mm_cmpge_ps(v, t)));
+    };
+    for (; i + 16 <= count; i += 16) {
+        const unsigned int mask = hits(data + i) | hits(data + i + 4) << 4 | hits(data + i + 8) << 8 |
+                                  hits(data + i + 12) << 12;
+        if (mask != 0) {
+            return i + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float32x4_t t = vdupq_n_f32(threshold);
+    auto hits = [t](const float* p) {
+        const float32x4_t v = vld1q_f32(p);
+        return Below ? vcltq_f32(v, t) : vcgeq_f32(v, t);
+    };
+    for (; i + 16 <= count; i += 16) {
+        const uint32x4_t any = vorrq_u32(vorrq_u32(hits(data + i), hits(data + i + 4)),
+                                         vorrq_u32(hits(data + i + 8), hits(data + i + 12)));
+        if (vmaxvq_u32(any) != 0) {
+            break; // The scalar loop finds the exact sample
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (Below ? data[i] < threshold : data[i] >= threshold) {
+            return i;
+        }
+    }
+    return count;
+}
+
+// Smallest and largest of count > 0 samples
+void rangeOf(const float* data, std::size_t count, float& low, float& high) {
+    std::size_t i = 1;
+    low = high = data[0];
+#if defined(__SSE2__)
+    if (count >= 8) {
+        __m128 lo = _mm_loadu_ps(data);
+        __m128 hi = lo;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const __m128 v = _mm_loadu_ps(data + i);
+            lo = _mm_min_ps(lo, v);
+            hi = _mm_max_ps(hi, v);
+        }
+        alignas(16) float lows[4];
+        alignas(16) float highs[4];
+        _mm_store_ps(lows, lo);
+        _mm_store_ps(highs, hi);
+        low = std::min({lows[0], lows[1], lows[2], lows[3]});
+        high = std::max({highs[0], highs[1], highs[2], highs[3]});
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    if (count >= 8) {
+        float32x4_t lo = vld1q_f32(data);
+        float32x4_t hi = lo;
+        for (i = 4; i + 4 <= count; i += 4) {
+            const float32x4_t v = vld1q_f32(data + i);
+            lo = vminq_f32(lo, v);
+            hi = vmaxq_f32(hi, v);
+        }
+        low = vminvq_f32(lo);
+        high = vmaxvq_f32(hi);
+    }
+#endif
+    for (; i < count; ++i) {
+        low = std::min(low, data[i]);
+        high = std::max(high, data[i]);
+    }
+}
+
+} // namespace
+
+SweepCapture::SweepCapture() : m_ring(std::make_unique<Sweep[]>(kSlots)) {
+}
+
+void SweepCapture::reset() {
+    m_completed = 0;
+    m_state = State::Arming;
+    m_waited = 0;
+}
+
+std::size_t SweepCapture::sweepCount() const {
+    return std::min(m_completed, kMaxSweeps);
+}
+
+const SweepCapture::Sweep& SweepCapture::sweep(std::size_t age) const {
+    return m_ring[(m_writeSlot + kSlots - 1 - age) % kSlots];
+}
+
+void SweepCapture::process(std::size_t frames, const Settings& settings) {
+    // A falling edge through the level is a rising edge of the negated source through the negated level
+    const float sign = settings.edge == TriggerEdge::Rising ? 1.f : -1.f;
+    const float* source = m_input[settings.source != 0 ? 1 : 0].data();
+    for (std::size_t i = 0; i < frames; ++i) {
+        m_trigger[i] = sign * source[i];
+    }
+    const float level = sign * settings.level;
+    const float armLevel = level - settings.hysteresis;
+    const bool autoRun = settings.mode == TriggerMode::Auto;
+
+    std::size_t i = 0;
+    while (i < frames) {
+        switch (m_state) {
+            case State::Holdoff: {
+                const std::size_t n = std::min(m_holdoffLeft, frames - i);
+                i += n;
+                m_holdoffLeft -= n;
+                if (m_holdoffLeft == 0) {
+                    m_state = State::Arming;
+                    m_waited = 0;
+                }
+                break;
+            }
+            case State::Arming:
+            case State::Armed: {
+                // In Auto mode the search stops where the wait runs out
+                std::size_t n = frames - i;
+                if (autoRun) {
+                    n = std::min(n, settings.autoFrames - std::min(m_waited, settings.autoFrames));
+                }
+                const std::size_t found = m_state == State::Arming
+                    ? findFirst<true>(m_trigger.data() + i, n, armLevel)
+                    : findFirst<false>(m_trigger.data() + i, n, level);
+                i += found;
+                m_waited += found;
+                if (found < n) {
+                    if (m_state == State::Arming) {
+                        m_state = State::Armed;
+                    } else {
+                        startSweep(true, settings);
+                    }
+                } else if (autoRun && m_waited >= settings.autoFrames) {
+                    startSweep(false, settings);
+                }
+                break;
+            }
+            case State::Capturing:
+                i += capture(i, frames - i, settings);
+                break;
+        }
+    }
+}
+
+void SweepCapture::startSweep(bool triggered, const Settings& settings) {
+    m_state = State::Capturing;
+    m_sweepFrames = std::clamp<std::size_t>(settings.sweepFrames, 1, kMaxSweepFrames);
+    m_captured = 0;
+    m_column = 0;
+    Sweep& sweep = m_ring[m_writeSlot];
+    sweep.columnCount = std::min(kColumns, m_sweepFrames);
+    sweep.triggered = triggered;
+}
+
+std::size_t SweepCapture::capture(std::size_t offset, std::size_t frames, const Settings& settings) {
+    Sweep& sweep = m_ring[m_writeSlot];
+    const std::size_t columns = sweep.columnCount;
+    std::size_t consumed = 0;
+
+    // Column c covers sweep frames [c * sweepFrames / columns, (c + 1) * sweepFrames / columns)
+    while (consumed < frames && m_captured < m_sweepFrames) {
+        const std::size_t columnStart = m_column * m_sweepFrames / columns;
+        const std::size_t columnEnd = (m_column + 1) * m_sweepFrames / columns;
+        const std::size_t n = std::min(columnEnd - m_captured, frames - consumed);
+        for (unsigned int channel = 0; channel < 2; ++channel) {
+            const float* data = m_input[channel].data() + offset + consumed;
+            Column& column = sweep.columns[channel][m_column];
+            float low;
+            float high;
+            rangeOf(data, n, low, high);
+            if (m_captured == columnStart) {
+                column = {low, high, data[0], data[n - 1]};
+            } else {
+                column.low = std::min(column.low, low);
+                column.high = std::max(column.high, high);
+                column.last = data[n - 1];
+            }
+        }
+        consumed += n;
+        m_captured += n;
+        if (m_captured == columnEnd) {
+            ++m_column;
+        }
+    }
+
+    if (m_captured == m_sweepFrames) {
+        m_writeSlot = (m_writeSlot + 1) % kSlots;
+        ++m_completed;
+        m_holdoffLeft = settings.holdoffFrames;
+        m_state = m_holdoffLeft > 0 ? State::Holdoff : State::Arming;
+        m_waited = 0;
+    }
+    return consumed;
+}
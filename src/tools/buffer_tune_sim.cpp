@@ -0,0 +1,145 @@
+// Offline test of BufferTuner with a simulated audio callback driver.
+//
+// Each simulated callback costs a fixed part plus a part per frame, with
+// random jitter and rare spikes; a callback that runs longer than its buffer
+// period flags an overflow on the next one, like a real backend. The tuner's
+// reopen decisions are applied at once (or ignored with --fixed, like a JACK
+// period). Part way through, the fixed cost steps up, as when scopes or
+// persistence are added. Exits non-zero if, once settled after the step, the
+// stream overflows, keeps less than the requested margin, or sits at a size
+// larger than the tuner itself recommends; with --fixed, if it was reopened.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../include/buffer_tuner.hpp"
+
+namespace {
+
+std::chrono::steady_clock::time_point simTime(double seconds) {
+    return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(seconds)));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int seconds = 90;
+    unsigned int sampleRate = 48000;
+    unsigned int startFrames = 256;
+    double fixedUs = 400.0;
+    double perFrameUs = 1.0;
+    double jitter = 0.1;
+    double spikeRate = 0.0002;
+    double stepAt = 30.0;
+    double stepFactor = 3.0;
+    double margin = 0.5;
+    double settleSeconds = 30.0;
+    bool fixed = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue) {
+            seconds = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--rate" && hasValue) {
+            sampleRate = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--start-frames" && hasValue) {
+            startFrames = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--fixed-us" && hasValue) {
+            fixedUs = std::stod(argv[++i]);
+        } else if (arg == "--per-frame-us" && hasValue) {
+            perFrameUs = std::stod(argv[++i]);
+        } else if (arg == "--jitter" && hasValue) {
+            jitter = std::stod(argv[++i]);
+        } else if (arg == "--spike-rate" && hasValue) {
+            spikeRate = std::stod(argv[++i]);
+        } else if (arg == "--step-at" && hasValue) {
+            stepAt = std::stod(argv[++i]);
+        } else if (arg == "--step-factor" && hasValue) {
+            stepFactor = std::stod(argv[++i]);
+        } else if (arg == "--margin" && hasValue) {
+            margin = std::stod(argv[++i]);
+        } else if (arg == "--settle" && hasValue) {
+            settleSeconds = std::stod(argv[++i]);
+        } else if (arg == "--fixed") {
+            fixed = true;
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--seconds n] [--rate hz] [--start-frames n] [--fixed-us us]\n"
+                      << "       [--per-frame-us us] [--jitter x] [--spike-rate p] [--step-at s] [--step-factor x]\n"
+                      << "       [--margin x] [--settle s] [--fixed]" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+
+    BufferTuner tuner(margin);
+    unsigned int frames = startFrames;
+    tuner.start(frames, sampleRate, fixed, simTime(0.0));
+
+    std::mt19937 rng(1234);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::cout << std::fixed << std::setprecision(3);
+    double now = 0.0;
+    bool overflowPending = false;
+    std::uint64_t settledOverflows = 0;
+    unsigned int settledWindows = 0;
+    unsigned int thinWindows = 0;
+    unsigned int reopens = 0;
+    const double settledFrom = stepAt + settleSeconds;
+    while (now < seconds) {
+        const double periodUs = 1e6 * frames / sampleRate;
+        const double load = now >= stepAt ? stepFactor : 1.0;
+        double costUs = (fixedUs * load + perFrameUs * frames) * (1.0 + jitter * std::abs(noise(rng)));
+        if (uniform(rng) < spikeRate) {
+            costUs *= 3.0;
+        }
+        tuner.recordCallback(std::chrono::nanoseconds(static_cast<long long>(costUs * 1000.0)), overflowPending);
+        if (overflowPending && now >= settledFrom) {
+            ++settledOverflows;
+        }
+        overflowPending = costUs > periodUs;
+        now += periodUs / 1e6;
+
+        if (!tuner.evaluate(simTime(now))) {
+            continue;
+        }
+        const BufferTuner::Report& report = tuner.report();
+        std::cout << "t=" << std::setw(7) << now << "s  " << std::setw(4) << report.bufferFrames << " frames ("
+                  << report.periodMs << " ms)  median " << report.medianMs << " ms  peak " << report.peakMs
+                  << " ms  margin " << std::setw(6) << 100.0 * report.margin << "%  overflows " << report.overflows
+                  << "  best " << report.recommendedFrames << (report.reopen ? "  -> reopen" : "") << std::endl;
+        if (now >= settledFrom) {
+            ++settledWindows;
+            if (report.margin < margin && !report.reopen) {
+                ++thinWindows;
+            }
+        }
+        if (report.reopen) {
+            frames = report.recommendedFrames;
+            overflowPending = false;
+            ++reopens;
+            tuner.start(frames, sampleRate, fixed, simTime(now));
+        }
+    }
+
+    const BufferTuner::Report& last = tuner.report();
+    std::cout << "Final: " << frames << " frames, " << reopens << " reopens, " << settledOverflows
+              << " overflows and " << thinWindows << "/" << settledWindows << " windows under the margin once settled"
+              << std::endl;
+
+    // A fixed-size stream can only be reported on, so it must never be reopened
+    bool ok = fixed ? reopens == 0 : settledWindows > 0 && settledOverflows == 0 && thinWindows == 0;
+    if (!fixed && last.recommendedFrames < frames) {
+        std::cout << "Settled at " << frames << " frames, but " << last.recommendedFrames << " would do" << std::endl;
+        ok = false;
+    }
+    std::cout << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
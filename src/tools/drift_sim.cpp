@@ -0,0 +1,219 @@
+// Offline test of StreamAggregator against deliberately skewed clocks.
+//
+// Simulates one master stream and up to three slave streams whose sample
+// clocks run a few hundred ppm off, with jittery callback timing. All streams
+// capture the same 20 Hz signal, so after aggregation every channel pair
+// should show it with a constant delay. Each simulated second prints the
+// ring level, the estimated drift and the delay of each slave against the
+// master. Exits non-zero if, once settled, a drift estimate is off, the
+// delay wanders or a ring runs dry.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/stream_aggregator.hpp"
+
+namespace {
+
+constexpr double kRate = 48000.0;
+constexpr double kSignalHz = 20.0;
+constexpr unsigned int kOutputPairs = 4;
+
+struct SimStream {
+    double skewPpm = 0.0;
+    unsigned int blockFrames = 256;
+    double trueRate = kRate;
+    std::uint64_t framesSent = 0;
+    double nextCallback = 0.0;
+    std::vector<float> block;
+};
+
+// Phase of the test signal over one second of one channel pair (quadrature correlation)
+struct PhaseMeter {
+    double i = 0.0;
+    double q = 0.0;
+    void add(float x, double t) {
+        i += x * std::cos(2.0 * M_PI * kSignalHz * t);
+        q += x * std::sin(2.0 * M_PI * kSignalHz * t);
+    }
+    double phase() const { return std::atan2(q, i); }
+    double amplitude(double n) const { return 2.0 * std::hypot(i, q) / n; }
+};
+
+bool parseSlave(const std::string& text, SimStream& stream) {
+    const auto colon = text.find(':');
+    try {
+        stream.skewPpm = std::stod(text.substr(0, colon));
+        if (colon != std::string::npos) {
+            stream.blockFrames = static_cast<unsigned int>(std::stoul(text.substr(colon + 1)));
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return stream.blockFrames > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int seconds = 120;
+    unsigned int settleSeconds = 60;
+    double jitterMs = 1.0;
+    double marginMs = 2.0;
+    SimStream master;
+    std::vector<SimStream> slaves;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue) {
+            seconds = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--settle" && hasValue) {
+            settleSeconds = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--jitter-ms" && hasValue) {
+            jitterMs = std::stod(argv[++i]);
+        } else if (arg == "--margin-ms" && hasValue) {
+            marginMs = std::stod(argv[++i]);
+        } else if (arg == "--master-block" && hasValue) {
+            master.blockFrames = static_cast<unsigned int>(std::stoul(argv[++i]));
+        } else if (arg == "--slave" && hasValue) {
+            SimStream slave;
+            if (!parseSlave(argv[++i], slave)) {
+                std::cerr << "Error: Invalid slave spec: " << argv[i] << std::endl;
+                return -1;
+            }
+            slaves.push_back(slave);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--seconds n] [--settle n] [--jitter-ms ms] [--margin-ms ms]\n"
+                      << "       [--master-block frames] [--slave skew-ppm[:block-frames]]...\n"
+                      << "Default slaves: 80:128 and -150:512" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+    if (slaves.empty()) {
+        slaves.resize(2);
+        slaves[0].skewPpm = 80.0;
+        slaves[0].blockFrames = 128;
+        slaves[1].skewPpm = -150.0;
+        slaves[1].blockFrames = 512;
+    }
+    if (slaves.size() >= kOutputPairs) {
+        std::cerr << "Error: At most " << kOutputPairs - 1 << " slaves" << std::endl;
+        return -1;
+    }
+
+    // Per output pair, phase meters for the current second
+    std::vector<PhaseMeter> meters(kOutputPairs);
+    std::uint64_t masterFrames = 0;
+    std::uint64_t meteredFrames = 0;
+    std::vector<std::vector<double>> delaysMs(slaves.size());
+
+    StreamAggregator aggregator(kOutputPairs * 2, marginMs,
+        [&](const float* frames, unsigned int nFrames, unsigned int nChannels, double) {
+            for (unsigned int f = 0; f < nFrames; ++f) {
+                const double t = static_cast<double>(masterFrames + f) / kRate;
+                for (unsigned int p = 0; p < kOutputPairs; ++p) {
+                    meters[p].add(frames[f * nChannels + 2 * p], t);
+                }
+            }
+            masterFrames += nFrames;
+            meteredFrames += nFrames;
+        });
+
+    aggregator.addStream({0}, static_cast<unsigned int>(kRate), master.blockFrames);
+    for (std::size_t s = 0; s < slaves.size(); ++s) {
+        slaves[s].trueRate = kRate * (1.0 + slaves[s].skewPpm * 1e-6);
+        aggregator.addStream({static_cast<unsigned int>(s + 1)}, static_cast<unsigned int>(kRate), slaves[s].blockFrames);
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> jitter(0.0, jitterMs / 1000.0);
+    std::vector<SimStream*> streams = {&master};
+    for (auto& slave : slaves) {
+        streams.push_back(&slave);
+    }
+    for (SimStream* stream : streams) {
+        stream->block.resize(static_cast<std::size_t>(stream->blockFrames) * 2);
+        stream->nextCallback = stream->blockFrames / stream->trueRate + jitter(rng);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::vector<std::uint64_t> settledUnderruns(slaves.size(), 0);
+    unsigned int second = 0;
+    while (second < seconds) {
+        // Run the callback that fires next; each delivers the block that just finished
+        SimStream* next = *std::min_element(streams.begin(), streams.end(),
+            [](const SimStream* a, const SimStream* b) { return a->nextCallback < b->nextCallback; });
+        const std::size_t index = static_cast<std::size_t>(std::find(streams.begin(), streams.end(), next) - streams.begin());
+        for (unsigned int f = 0; f < next->blockFrames; ++f) {
+            const double t = static_cast<double>(next->framesSent + f) / next->trueRate;
+            next->block[2 * f] = static_cast<float>(0.5 * std::cos(2.0 * M_PI * kSignalHz * t));
+            next->block[2 * f + 1] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * kSignalHz * t));
+        }
+        const auto arrival = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(next->nextCallback)));
+        aggregator.streamInput(index, next->block.data(), SampleFormat::Float32, next->blockFrames, 2,
+                               static_cast<double>(next->framesSent) / kRate, arrival);
+        next->framesSent += next->blockFrames;
+        next->nextCallback = (next->framesSent + next->blockFrames) / next->trueRate + jitter(rng);
+
+        if (meteredFrames < static_cast<std::uint64_t>(kRate)) {
+            continue;
+        }
+
+        // One simulated second done: report and reset the meters
+        ++second;
+        std::cout << "t=" << std::setw(4) << second << "s";
+        for (std::size_t s = 0; s < slaves.size(); ++s) {
+            const StreamAggregator::StreamStats stats = aggregator.stats(s + 1);
+            const PhaseMeter& meter = meters[s + 1];
+            double delayMs = std::nan("");
+            if (meter.amplitude(static_cast<double>(meteredFrames)) > 0.4) {
+                // Only whole seconds of resampled signal give a clean phase
+                const double phase = std::remainder(meters[0].phase() - meter.phase(), 2.0 * M_PI);
+                delayMs = phase / (2.0 * M_PI * kSignalHz) * 1000.0;
+            }
+            std::cout << " | slave " << s + 1 << ": level " << std::setw(6) << stats.levelMs << "/" << stats.targetMs
+                      << " ms, drift " << std::setw(8) << stats.driftPpm << " ppm, delay " << std::setw(6) << delayMs
+                      << " ms, underruns " << stats.underruns;
+            if (second == settleSeconds) {
+                settledUnderruns[s] = stats.underruns;
+            }
+            if (second > settleSeconds) {
+                delaysMs[s].push_back(delayMs);
+            }
+        }
+        std::cout << std::endl;
+        std::fill(meters.begin(), meters.end(), PhaseMeter{});
+        meteredFrames = 0;
+    }
+
+    bool ok = true;
+    for (std::size_t s = 0; s < slaves.size(); ++s) {
+        const StreamAggregator::StreamStats stats = aggregator.stats(s + 1);
+        // The slave's clock runs fast by skew, so it must be consumed faster by the same amount
+        const double driftError = std::abs(stats.driftPpm - slaves[s].skewPpm);
+        double wander = 0.0;
+        if (std::any_of(delaysMs[s].begin(), delaysMs[s].end(), [](double d) { return std::isnan(d); })) {
+            wander = INFINITY;
+        } else if (!delaysMs[s].empty()) {
+            const auto [minIt, maxIt] = std::minmax_element(delaysMs[s].begin(), delaysMs[s].end());
+            wander = *maxIt - *minIt;
+        }
+        const std::uint64_t underruns = stats.underruns - settledUnderruns[s];
+        // Half a millisecond is 1% of the test signal's period
+        const bool passed = driftError < 10.0 && wander < 0.5 && underruns == 0 && stats.overflows == 0;
+        std::cout << "Slave " << s + 1 << " (" << slaves[s].skewPpm << " ppm, " << slaves[s].blockFrames
+                  << " frames): drift error " << driftError << " ppm, delay wander " << wander << " ms, "
+                  << underruns << " underruns after settling, " << stats.overflows << " overflows: "
+                  << (passed ? "PASS" : "FAIL") << std::endl;
+        ok = ok && passed;
+    }
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,135 @@
+// Throughput benchmark for the oscilloscope ingest path.
+//
+// Feeds synthetic interleaved blocks through every processSamples
+// specialization (sample format x channel stride) and prints frames per
+// second. The "float32 via int16" row is the old path, where float input had
+// to be converted to int16 before it reached the scope. Persistence is kept
+// tiny so the per-block geometry rebuild does not drown out the ingest cost.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/oscilloscope.hpp"
+
+namespace {
+
+constexpr std::size_t kBlockFrames = 4096;
+
+// Interleaved test signal in the given format, stored as raw bytes
+std::vector<std::uint8_t> makeBlock(SampleFormat format, std::size_t stride) {
+    const std::size_t bytes = bytesPerSample(format);
+    std::vector<std::uint8_t> block(kBlockFrames * stride * bytes);
+    for (std::size_t f = 0; f < kBlockFrames; ++f) {
+        for (std::size_t c = 0; c < stride; ++c) {
+            const double v = 0.8 * std::sin(2.0 * M_PI * (c + 1) * static_cast<double>(f) / 512.0);
+            std::uint8_t* dst = block.data() + (f * stride + c) * bytes;
+            switch (format) {
+                case SampleFormat::Int16: {
+                    const auto s = static_cast<std::int16_t>(v * 32767.0);
+                    std::memcpy(dst, &s, sizeof(s));
+                    break;
+                }
+                case SampleFormat::Int24: {
+                    const auto s = static_cast<std::int32_t>(v * 8388607.0);
+                    dst[0] = s & 0xff;
+                    dst[1] = (s >> 8) & 0xff;
+                    dst[2] = (s >> 16) & 0xff;
+                    break;
+                }
+                case SampleFormat::Int32: {
+                    const auto s = static_cast<std::int32_t>(v * 2147483647.0);
+                    std::memcpy(dst, &s, sizeof(s));
+                    break;
+                }
+                case SampleFormat::Float32: {
+                    const auto s = static_cast<float>(v);
+                    std::memcpy(dst, &s, sizeof(s));
+                    break;
+                }
+            }
+        }
+    }
+    return block;
+}
+
+template <typename F>
+double framesPerSecond(double seconds, F&& runBlock) {
+    using clock = std::chrono::steady_clock;
+    std::size_t blocks = 0;
+    const auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+    do {
+        for (int i = 0; i < 16; ++i) {
+            runBlock();
+        }
+        blocks += 16;
+        elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::duration<double>(seconds));
+    return static_cast<double>(blocks * kBlockFrames) / std::chrono::duration<double>(elapsed).count();
+}
+
+void printRow(const std::string& label, std::size_t stride, const char* dispatch, double fps) {
+    std::cout << std::left << std::setw(20) << label << std::right << std::setw(8) << stride << std::setw(10)
+              << dispatch << std::setw(14) << std::fixed << std::setprecision(1) << fps / 1e6 << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    double seconds = 0.5;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc) {
+            seconds = std::stod(argv[++i]);
+        } else {
+            std::cout << "Usage: " << argv[0] << " [--seconds per-case]" << std::endl;
+            return arg == "--help" || arg == "-h" ? 0 : -1;
+        }
+    }
+
+    Oscilloscope scope;
+    // A real view, so points spread out and get finite alphas and normals as in the renderer
+    scope.updateView({800, 600});
+    scope.setPersistenceSamples(2);
+    scope.releaseRetiredBuffers();
+    const auto now = std::chrono::steady_clock::now();
+
+    std::cout << std::left << std::setw(20) << "format" << std::right << std::setw(8) << "stride" << std::setw(10)
+              << "dispatch" << std::setw(14) << "Mframes/s" << std::endl;
+
+    for (SampleFormat format : {SampleFormat::Int16, SampleFormat::Int24, SampleFormat::Int32, SampleFormat::Float32}) {
+        for (std::size_t stride : {2, 8, 16}) {
+            const std::vector<std::uint8_t> block = makeBlock(format, stride);
+            const Oscilloscope::IngestFn fixed = Oscilloscope::ingestFor(format, stride);
+            // A stride with no fixed specialization falls through to the runtime-stride one
+            const Oscilloscope::IngestFn runtime = Oscilloscope::ingestFor(format, stride + 1);
+            printRow(sampleFormatName(format), stride, "fixed", framesPerSecond(seconds, [&]() {
+                (scope.*fixed)(block.data(), kBlockFrames, stride, now);
+            }));
+            printRow(sampleFormatName(format), stride, "runtime", framesPerSecond(seconds, [&]() {
+                (scope.*runtime)(block.data(), kBlockFrames, stride, now);
+            }));
+        }
+    }
+
+    // Baseline: convert float to int16 up front, as a fixed int16 stream format forced before
+    for (std::size_t stride : {2, 8, 16}) {
+        const std::vector<std::uint8_t> block = makeBlock(SampleFormat::Float32, stride);
+        std::vector<std::int16_t> converted(kBlockFrames * stride);
+        printRow("float32 via int16", stride, "runtime", framesPerSecond(seconds, [&]() {
+            const auto* src = reinterpret_cast<const float*>(block.data());
+            for (std::size_t i = 0; i < converted.size(); ++i) {
+                converted[i] = static_cast<std::int16_t>(std::lrint(std::clamp(src[i], -1.f, 1.f) * 32767.f));
+            }
+            scope.processSamples<std::int16_t>(converted.data(), kBlockFrames, stride, now);
+        }));
+    }
+    return 0;
+}
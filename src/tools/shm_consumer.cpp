@@ -0,0 +1,122 @@
+// Reference consumer for OSCAR's shared-memory frame export.
+//
+// Maps the ring published by `oscar_render --export-shm <name>`, copies out
+// every new frame and prints once per second how many frames arrived, how
+// many were skipped and how old they were on arrival. With --dump, the last
+// received frame is written as raw RGBA (top-down) when the consumer exits.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/shm_frame.hpp"
+
+namespace {
+
+std::atomic<bool> running{true};
+
+void handleSignal(int) {
+    running = false;
+}
+
+void writeFrame(const std::string& path, const shmframe::FrameInfo& info, const std::vector<std::uint8_t>& pixels) {
+    std::ofstream out(path, std::ios::binary);
+    // Flip to top-down so the file can be viewed directly
+    for (std::uint32_t row = 0; row < info.height; ++row) {
+        std::uint32_t src = (info.flags & shmframe::kFlagBottomUp) ? info.height - 1 - row : row;
+        out.write(reinterpret_cast<const char*>(pixels.data() + static_cast<std::size_t>(src) * info.stride), info.width * 4);
+    }
+    std::cout << "Wrote " << info.width << "x" << info.height << " RGBA frame to " << path << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name = "/oscar";
+    std::string dumpPath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--dump" && i + 1 < argc) {
+            dumpPath = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            std::cout << "Usage: " << argv[0] << " [shm-name] [--dump frame.rgba]" << std::endl;
+            return 0;
+        } else {
+            name = arg[0] == '/' ? arg : "/" + arg;
+        }
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    shmframe::FrameRingReader reader;
+    std::vector<std::uint8_t> pixels;
+    std::vector<std::uint8_t> scratch;
+    shmframe::FrameInfo info;
+    bool haveFrame = false;
+    std::uint64_t lastSequence = 0;
+
+    unsigned int frames = 0;
+    std::uint64_t skipped = 0;
+    double totalAgeMs = 0.0;
+    double maxAgeMs = 0.0;
+    auto lastReport = std::chrono::steady_clock::now();
+
+    while (running) {
+        if (!reader.isValid()) {
+            // Writer not started yet, exited, or re-created the ring at a larger size
+            if (!reader.open(name)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            pixels.resize(reader.maxFrameBytes());
+            scratch.resize(reader.maxFrameBytes());
+            lastSequence = reader.latestSequence();
+            std::cout << "Mapped " << name << " (" << reader.maxFrameBytes() << " bytes per frame)" << std::endl;
+        }
+
+        shmframe::FrameInfo next;
+        // The writer may lap a slot mid-copy, so only a read that succeeded replaces the last good frame
+        if (reader.readLatest(lastSequence, next, scratch.data())) {
+            pixels.swap(scratch);
+            if (lastSequence != 0 && next.sequence > lastSequence + 1) {
+                skipped += next.sequence - lastSequence - 1;
+            }
+            double ageMs = static_cast<double>(shmframe::nowNs() - next.timestampNs) / 1e6;
+            totalAgeMs += ageMs;
+            maxAgeMs = std::max(maxAgeMs, ageMs);
+            ++frames;
+            lastSequence = next.sequence;
+            info = next;
+            haveFrame = true;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastReport >= std::chrono::seconds(1)) {
+            if (frames > 0) {
+                std::cout << frames << " frames (" << info.width << "x" << info.height << "), "
+                          << skipped << " skipped, age mean " << totalAgeMs / frames << " ms, "
+                          << "max " << maxAgeMs << " ms" << std::endl;
+            }
+            frames = 0;
+            skipped = 0;
+            totalAgeMs = 0.0;
+            maxAgeMs = 0.0;
+            lastReport = now;
+        }
+    }
+
+    if (haveFrame && !dumpPath.empty()) {
+        writeFrame(dumpPath, info, pixels);
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Test sender for OSCAR's UDP audio input.
+//
+// Streams a synthetic Lissajous figure per channel pair to
+// `oscar_render --input udp`. Network trouble can be simulated with random
+// loss, extra send delay (jitter) and a sender clock running off-rate (skew).
+// With --loopback, a receiver with the renderer's jitter buffer runs in the
+// same process on 127.0.0.1 and reports end-to-end latency and jitter.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/udp_audio.hpp"
+
+namespace {
+
+std::atomic<bool> running{true};
+
+void handleSignal(int) {
+    running = false;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host <addr>       Destination address (default: 127.0.0.1)\n"
+              << "  --port <n>          Destination port (default: " << udpaudio::kDefaultPort << ")\n"
+              << "  --channels <n>      Interleaved channels (default: 8)\n"
+              << "  --rate <hz>         Sample rate (default: 48000)\n"
+              << "  --frames <n>        Frames per packet (default: 64)\n"
+              << "  --seconds <n>       Stop after n seconds (default: forever, 10 with --loopback)\n"
+              << "  --loss <p>          Drop packets with probability p (0-1)\n"
+              << "  --jitter-ms <ms>    Delay each send by a random 0..ms\n"
+              << "  --skew-ppm <ppm>    Run the sender clock fast (+) or slow (-)\n"
+              << "  --loopback          Receive in-process on 127.0.0.1 and report latency and jitter" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    unsigned short port = udpaudio::kDefaultPort;
+    unsigned int channels = 8;
+    unsigned int rate = 48000;
+    unsigned int frames = 64;
+    double seconds = 0.0;
+    double loss = 0.0;
+    double jitterMs = 0.0;
+    double skewPpm = 0.0;
+    bool loopback = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--host" && hasValue) {
+                host = argv[++i];
+            } else if (arg == "--port" && hasValue) {
+                port = static_cast<unsigned short>(std::stoul(argv[++i]));
+            } else if (arg == "--channels" && hasValue) {
+                channels = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--rate" && hasValue) {
+                rate = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--frames" && hasValue) {
+                frames = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--seconds" && hasValue) {
+                seconds = std::stod(argv[++i]);
+            } else if (arg == "--loss" && hasValue) {
+                loss = std::stod(argv[++i]);
+            } else if (arg == "--jitter-ms" && hasValue) {
+                jitterMs = std::stod(argv[++i]);
+            } else if (arg == "--skew-ppm" && hasValue) {
+                skewPpm = std::stod(argv[++i]);
+            } else if (arg == "--loopback") {
+                loopback = true;
+            } else {
+                printUsage(argv[0]);
+                return arg == "--help" || arg == "-h" ? 0 : -1;
+            }
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid option value." << std::endl;
+        return -1;
+    }
+
+    // The receiver drops packets outside these limits as malformed, so refuse to send them
+    if (rate < udpaudio::kMinSampleRate || rate > udpaudio::kMaxSampleRate) {
+        std::cerr << "Error: Sample rate must be between " << udpaudio::kMinSampleRate << " and "
+                  << udpaudio::kMaxSampleRate << " Hz." << std::endl;
+        return -1;
+    }
+    if (frames > udpaudio::kMaxPacketFrames) {
+        std::cerr << "Error: At most " << udpaudio::kMaxPacketFrames << " frames fit a packet." << std::endl;
+        return -1;
+    }
+    const std::size_t payloadBytes = static_cast<std::size_t>(frames) * channels * sizeof(std::int16_t);
+    if (channels == 0 || frames == 0 || sizeof(udpaudio::PacketHeader) + payloadBytes > udpaudio::kMaxPacketBytes) {
+        std::cerr << "Error: Packet of " << frames << " frames x " << channels << " channels does not fit a datagram." << std::endl;
+        return -1;
+    }
+    if (loopback) {
+        host = "127.0.0.1";
+        if (seconds <= 0.0) {
+            seconds = 10.0;
+        }
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    std::unique_ptr<udpaudio::UdpAudioReceiver> receiver;
+    if (loopback) {
+        receiver = std::make_unique<udpaudio::UdpAudioReceiver>(port, channels, 256, 2.0, 200.0,
+            [](const std::int16_t*, unsigned int, unsigned int, double) {});
+        receiver->setReportStats(true);
+        if (!receiver->start()) {
+            return -1;
+        }
+    }
+
+    asio::io_context io_context;
+    asio::ip::udp::socket socket(io_context);
+    asio::ip::udp::endpoint destination;
+    try {
+        socket.open(asio::ip::udp::v4());
+        destination = asio::ip::udp::endpoint(asio::ip::make_address(host), port);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Could not open sender socket: " << e.what() << std::endl;
+        return -1;
+    }
+    std::cout << "Sending " << channels << " channels at " << rate << " Hz, " << frames << " frames per packet, to "
+              << host << ":" << port << std::endl;
+
+    std::vector<char> packet(sizeof(udpaudio::PacketHeader) + payloadBytes);
+    auto* samples = reinterpret_cast<std::int16_t*>(packet.data() + sizeof(udpaudio::PacketHeader));
+    udpaudio::PacketHeader header{udpaudio::kMagic, udpaudio::kVersion, static_cast<std::uint16_t>(channels),
+                                  0, frames, rate, 0, 0};
+
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    // A skewed sender produces its nominal rate against a clock that runs fast or slow
+    const double packetSeconds = frames / (rate * (1.0 + skewPpm * 1e-6));
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    std::uint64_t sent = 0;
+    std::uint64_t dropped = 0;
+
+    for (std::uint32_t sequence = 0; running; ++sequence) {
+        const std::uint64_t firstFrame = static_cast<std::uint64_t>(sequence) * frames;
+        if (seconds > 0.0 && firstFrame >= seconds * rate) {
+            break;
+        }
+        std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<std::int64_t>(sequence * packetSeconds * 1e9)));
+
+        for (unsigned int j = 0; j < frames; ++j) {
+            const double t = static_cast<double>(firstFrame + j) / rate;
+            for (unsigned int c = 0; c < channels; ++c) {
+                const double f = 110.0 * (c / 2 + 1);
+                const double phase = 2.0 * M_PI * f * t * (c % 2 ? 1.5 : 1.0);
+                samples[j * channels + c] = static_cast<std::int16_t>(16000.0 * std::sin(phase));
+            }
+        }
+        header.sequence = sequence;
+        header.senderTimeNs = udpaudio::nowNs();
+        std::memcpy(packet.data(), &header, sizeof(header));
+
+        if (jitterMs > 0.0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(static_cast<std::int64_t>(uniform(rng) * jitterMs * 1e6)));
+        }
+        if (loss > 0.0 && uniform(rng) < loss) {
+            ++dropped;
+        } else {
+            asio::error_code ec;
+            socket.send_to(asio::buffer(packet.data(), packet.size()), destination, 0, ec);
+            if (ec) {
+                std::cerr << "Send error: " << ec.message() << std::endl;
+            }
+            ++sent;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (!loopback && now - lastReport >= std::chrono::seconds(1)) {
+            std::cout << "Sent " << sent << " packets (" << dropped << " dropped on purpose)" << std::endl;
+            sent = 0;
+            dropped = 0;
+            lastReport = now;
+        }
+    }
+
+    if (receiver) {
+        // Let the jitter buffer drain before the final summary
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        receiver->stop();
+    }
+    return 0;
+}
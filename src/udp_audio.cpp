@@ -0,0 +1,177 @@
+#include "include/udp_audio.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+namespace udpaudio {
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+UdpAudioReceiver::UdpAudioReceiver(unsigned short port, unsigned int channels, unsigned int blockFrames,
+                                   double minDelayMs, double maxDelayMs, Sink sink)
+    : m_port(port), m_channels(channels), m_blockFrames(blockFrames), m_sink(std::move(sink)),
+      m_socket(m_io), m_timer(m_io), m_block(static_cast<std::size_t>(blockFrames) * channels),
+      m_jitter(channels, minDelayMs, maxDelayMs) {
+    m_latenciesMs.reserve(4096);
+}
+
+UdpAudioReceiver::~UdpAudioReceiver() {
+    stop();
+}
+
+bool UdpAudioReceiver::start() {
+    asio::ip::udp::endpoint listen_endpoint(asio::ip::udp::v4(), m_port);
+    asio::error_code ec;
+    m_socket.open(listen_endpoint.protocol(), ec);
+    if (!ec) {
+        // A larger kernel buffer rides out short stalls of this thread; failure is not fatal
+        asio::error_code ignored;
+        m_socket.set_option(asio::ip::udp::socket::receive_buffer_size(1 << 20), ignored);
+        m_socket.bind(listen_endpoint, ec);
+    }
+    if (ec) {
+        std::cerr << "Error: Could not open UDP audio port " << m_port << ": " << ec.message() << std::endl;
+        return false;
+    }
+    std::cout << "UDP audio input listening on port " << m_port << std::endl;
+
+    m_running = true;
+    m_nextPlayout = std::chrono::steady_clock::now();
+    m_lastReport = m_nextPlayout;
+    startReceive();
+    schedulePlayout();
+    m_thread = std::thread([this]() {
+        try {
+            m_io.run();
+        } catch (const std::exception& e) {
+            std::cerr << "UDP audio thread exception: " << e.what() << std::endl;
+        }
+    });
+    return true;
+}
+
+void UdpAudioReceiver::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_io.stop();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    asio::error_code ec;
+    m_socket.close(ec);
+    report(true);
+}
+
+void UdpAudioReceiver::startReceive() {
+    m_socket.async_receive_from(asio::buffer(m_packet), m_remote,
+        [this](const asio::error_code& error, std::size_t bytes) {
+            handleReceive(error, bytes);
+        });
+}
+
+void UdpAudioReceiver::handleReceive(const asio::error_code& error, std::size_t bytes) {
+    if (error) {
+        if (error == asio::error::operation_aborted || !m_running) {
+            return;
+        }
+        std::cerr << "UDP audio receive error: " << error.message() << std::endl;
+    } else {
+        const std::uint64_t arrival = nowNs();
+        // A runt datagram fills only part of the header; the rest stays zero and fails the checks below
+        PacketHeader header{};
+        std::memcpy(&header, m_packet.data(), std::min(bytes, sizeof(header)));
+        const std::size_t payload = static_cast<std::size_t>(header.frames) * header.channels * sizeof(std::int16_t);
+        // The header sizes the jitter buffer, so anything out of range is rejected before it gets there
+        if (bytes < sizeof(header) || header.magic != kMagic || header.version != kVersion ||
+            header.channels == 0 || header.channels > m_channels || header.frames == 0 ||
+            header.frames > kMaxPacketFrames || header.sampleRate < kMinSampleRate ||
+            header.sampleRate > kMaxSampleRate || sizeof(header) + payload != bytes) {
+            ++m_malformed;
+        } else {
+            m_jitter.push(header.sequence, header.senderTimeNs,
+                          reinterpret_cast<const std::int16_t*>(m_packet.data() + sizeof(header)),
+                          header.frames, header.channels, header.sampleRate, arrival);
+        }
+    }
+    if (m_running) {
+        startReceive();
+    }
+}
+
+void UdpAudioReceiver::schedulePlayout() {
+    m_timer.expires_at(m_nextPlayout);
+    m_timer.async_wait([this](const asio::error_code& error) {
+        if (!error && m_running) {
+            playout();
+        }
+    });
+}
+
+void UdpAudioReceiver::playout() {
+    // Until the first packet arrives, tick at a nominal rate
+    const unsigned int rate = m_jitter.sampleRate() > 0 ? m_jitter.sampleRate() : 48000;
+    m_sampleRate.store(m_jitter.sampleRate(), std::memory_order_relaxed);
+    const auto period = std::chrono::nanoseconds(static_cast<std::int64_t>(m_blockFrames * 1e9 / rate));
+
+    std::uint64_t senderTimeNs = 0;
+    if (m_jitter.pull(m_block.data(), m_blockFrames, senderTimeNs)) {
+        if (senderTimeNs != 0 && m_latenciesMs.size() < m_latenciesMs.capacity()) {
+            m_latenciesMs.push_back(static_cast<double>(nowNs() - senderTimeNs) / 1e6);
+        }
+        m_sink(m_block.data(), m_blockFrames, m_channels, static_cast<double>(m_blocksPlayed * m_blockFrames) / rate);
+        ++m_blocksPlayed;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    m_nextPlayout += period;
+    if (m_nextPlayout < now - 4 * period) {
+        // This thread stalled; resume from now rather than bursting to catch up
+        m_nextPlayout = now;
+    }
+    if (now - m_lastReport >= std::chrono::seconds(1)) {
+        report(false);
+        m_lastReport = now;
+    }
+    schedulePlayout();
+}
+
+void UdpAudioReceiver::report(bool final) {
+    const JitterBuffer::Stats stats = m_jitter.stats();
+    m_jitter.resetCounters();
+    m_totalPackets += stats.received;
+    m_totalLost += stats.lost;
+    m_totalConcealed += stats.concealedFrames;
+
+    if (m_reportStats && !final && stats.received > 0) {
+        std::cout << "UDP audio: " << stats.received << " packets, " << stats.lost << " lost, " << stats.late << " late, "
+                  << stats.foreign << " of another format, "
+                  << stats.concealedFrames << " frames concealed, jitter " << stats.jitterMs << " ms, buffer "
+                  << stats.levelMs << "/" << stats.targetMs << " ms, rate " << stats.rateRatio;
+        if (!m_latenciesMs.empty()) {
+            const double n = static_cast<double>(m_latenciesMs.size());
+            const double mean = std::accumulate(m_latenciesMs.begin(), m_latenciesMs.end(), 0.0) / n;
+            double variance = 0.0;
+            for (double l : m_latenciesMs) {
+                variance += (l - mean) * (l - mean);
+            }
+            const auto [minIt, maxIt] = std::minmax_element(m_latenciesMs.begin(), m_latenciesMs.end());
+            std::cout << ", latency mean " << mean << " ms (min " << *minIt << ", max " << *maxIt
+                      << ", sd " << std::sqrt(variance / n) << ")";
+        }
+        std::cout << std::endl;
+    }
+    m_latenciesMs.clear();
+
+    if (final) {
+        std::cout << "UDP audio: received " << m_totalPackets << " packets, " << m_totalLost << " lost, "
+                  << m_totalConcealed << " frames concealed, " << m_malformed << " malformed" << std::endl;
+    }
+}
+
+} // namespace udpaudio
@@ -0,0 +1,73 @@
+#include "include/worker_pool.hpp"
+
+WorkerPool::WorkerPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 1; i < threads; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_start.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::runTasks() {
+    for (std::size_t i = m_next.fetch_add(1); i < m_count; i = m_next.fetch_add(1)) {
+        (*m_task)(i);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_start.wait(lock, [&]() { return m_stopping || m_generation != seen; });
+        if (m_stopping) {
+            return;
+        }
+        seen = m_generation;
+        lock.unlock();
+        runTasks();
+        lock.lock();
+        if (--m_busy == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    if (m_threads.empty() || count == 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_next = 0;
+        m_busy = static_cast<unsigned int>(m_threads.size());
+        ++m_generation;
+    }
+    m_start.notify_all();
+    runTasks();
+
+    // Every worker checks in, even one that found no task left, so none can still hold m_task
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_busy == 0; });
+    m_task = nullptr;
+}